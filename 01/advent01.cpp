@@ -38,8 +38,8 @@ int main(int argc, char* argv[])
 
     auto const masses = parseInput(*input);
 
-    std::cout << "First result is " << total_fuel(masses) << std::endl;
-    std::cout << "Second result is " << total_fuel_with_fuel(masses) << std::endl;
+    std::cout << "First result is " << total_fuel_batch(masses) << std::endl;
+    std::cout << "Second result is " << total_fuel_with_fuel_batch(masses) << std::endl;
 
     return 0;
 }
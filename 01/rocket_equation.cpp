@@ -58,7 +58,32 @@ mass of the added fuel? (Calculate the fuel requirements for each module separat
 #include <range/v3/numeric/accumulate.hpp>
 #include <range/v3/range/conversion.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+
+// SSE2 is part of x86-64; 32 bit x86 only has it when the compiler is allowed to use it
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define ADVENT01_HAS_X86_KERNELS 1
+#   include <immintrin.h>
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#       define ADVENT01_TARGET_AVX2
+#   else
+#       define ADVENT01_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#else
+#   define ADVENT01_HAS_X86_KERNELS 0
+#endif
 
 std::vector<int> parseInput(std::string_view input)
 {
@@ -90,3 +115,406 @@ int total_fuel_with_fuel(std::vector<int> const& masses)
 {
     return ranges::accumulate(masses | ranges::views::transform(rocket_equation_with_fuel), 0);
 }
+
+namespace {
+// x / 3 == (x * 0xAAAAAAAB) >> 33 holds for all x in [0, 2^32)
+std::uint64_t constexpr div3_magic = 0xAAAAAAABu;
+int constexpr div3_shift = 33;
+
+std::int64_t total_fuel_scalar(std::span<int const> masses)
+{
+    std::int64_t ret = 0;
+    for (int const m : masses) { ret += rocket_equation(m); }
+    return ret;
+}
+
+std::int64_t total_fuel_with_fuel_scalar(std::span<int const> masses)
+{
+    std::int64_t ret = 0;
+    for (int const m : masses) {
+        for (int fuel = rocket_equation(m); fuel > 0; fuel = rocket_equation(fuel)) { ret += fuel; }
+    }
+    return ret;
+}
+
+#if ADVENT01_HAS_X86_KERNELS
+/* SSE2 */
+__m128i div3_unsigned_sse2(__m128i x)
+{
+    __m128i const magic = _mm_set1_epi64x(div3_magic);
+    __m128i const even = _mm_srli_epi64(_mm_mul_epu32(x, magic), div3_shift);
+    __m128i const odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), magic), div3_shift);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+__m128i div3_signed_sse2(__m128i x)
+{
+    // division truncates towards zero, so divide the magnitude and restore the sign
+    __m128i const sign = _mm_srai_epi32(x, 31);
+    __m128i const abs = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+    return _mm_sub_epi32(_mm_xor_si128(div3_unsigned_sse2(abs), sign), sign);
+}
+
+__m128i add_widened_sse2(__m128i acc, __m128i x)
+{
+    __m128i const sign = _mm_srai_epi32(x, 31);
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sign));
+    return _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sign));
+}
+
+std::int64_t horizontal_sum_sse2(__m128i acc)
+{
+    alignas(16) std::int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1];
+}
+
+std::int64_t total_fuel_sse2(std::span<int const> masses)
+{
+    std::size_t constexpr block_size = 4;
+    std::size_t const n_blocks = masses.size() / block_size;
+    __m128i const two = _mm_set1_epi32(2);
+    __m128i acc = _mm_setzero_si128();
+    for (std::size_t i = 0; i < n_blocks; ++i) {
+        __m128i const m = _mm_loadu_si128(reinterpret_cast<__m128i const*>(masses.data() + i * block_size));
+        acc = add_widened_sse2(acc, _mm_sub_epi32(div3_signed_sse2(m), two));
+    }
+    return horizontal_sum_sse2(acc) + total_fuel_scalar(masses.subspan(n_blocks * block_size));
+}
+
+std::int64_t total_fuel_with_fuel_sse2(std::span<int const> masses)
+{
+    std::size_t constexpr block_size = 4;
+    std::size_t const n_blocks = masses.size() / block_size;
+    __m128i const two = _mm_set1_epi32(2);
+    __m128i const zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    for (std::size_t i = 0; i < n_blocks; ++i) {
+        __m128i const m = _mm_loadu_si128(reinterpret_cast<__m128i const*>(masses.data() + i * block_size));
+        __m128i fuel = _mm_sub_epi32(div3_signed_sse2(m), two);
+        for (;;) {
+            // lanes whose fuel dropped to zero or below stay masked out, as div3(0) - 2 is negative again
+            __m128i const active = _mm_cmpgt_epi32(fuel, zero);
+            if (_mm_movemask_epi8(active) == 0) { break; }
+            fuel = _mm_and_si128(fuel, active);
+            acc = add_widened_sse2(acc, fuel);
+            fuel = _mm_sub_epi32(div3_unsigned_sse2(fuel), two);
+        }
+    }
+    return horizontal_sum_sse2(acc) + total_fuel_with_fuel_scalar(masses.subspan(n_blocks * block_size));
+}
+
+/* AVX2 */
+ADVENT01_TARGET_AVX2 __m256i div3_unsigned_avx2(__m256i x)
+{
+    __m256i const magic = _mm256_set1_epi64x(div3_magic);
+    __m256i const even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), div3_shift);
+    __m256i const odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), div3_shift);
+    return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+ADVENT01_TARGET_AVX2 __m256i div3_signed_avx2(__m256i x)
+{
+    __m256i const sign = _mm256_srai_epi32(x, 31);
+    return _mm256_sign_epi32(div3_unsigned_avx2(_mm256_abs_epi32(x)), _mm256_or_si256(sign, _mm256_set1_epi32(1)));
+}
+
+ADVENT01_TARGET_AVX2 __m256i add_widened_avx2(__m256i acc, __m256i x)
+{
+    acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+    return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+}
+
+ADVENT01_TARGET_AVX2 std::int64_t horizontal_sum_avx2(__m256i acc)
+{
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+ADVENT01_TARGET_AVX2 std::int64_t total_fuel_avx2(std::span<int const> masses)
+{
+    std::size_t constexpr block_size = 8;
+    std::size_t const n_blocks = masses.size() / block_size;
+    __m256i const two = _mm256_set1_epi32(2);
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < n_blocks; ++i) {
+        __m256i const m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(masses.data() + i * block_size));
+        acc = add_widened_avx2(acc, _mm256_sub_epi32(div3_signed_avx2(m), two));
+    }
+    return horizontal_sum_avx2(acc) + total_fuel_scalar(masses.subspan(n_blocks * block_size));
+}
+
+ADVENT01_TARGET_AVX2 std::int64_t total_fuel_with_fuel_avx2(std::span<int const> masses)
+{
+    std::size_t constexpr block_size = 8;
+    std::size_t const n_blocks = masses.size() / block_size;
+    __m256i const two = _mm256_set1_epi32(2);
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < n_blocks; ++i) {
+        __m256i const m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(masses.data() + i * block_size));
+        __m256i fuel = _mm256_sub_epi32(div3_signed_avx2(m), two);
+        for (;;) {
+            __m256i const active = _mm256_cmpgt_epi32(fuel, zero);
+            if (_mm256_testz_si256(active, active)) { break; }
+            fuel = _mm256_and_si256(fuel, active);
+            acc = add_widened_avx2(acc, fuel);
+            fuel = _mm256_sub_epi32(div3_unsigned_avx2(fuel), two);
+        }
+    }
+    return horizontal_sum_avx2(acc) + total_fuel_with_fuel_scalar(masses.subspan(n_blocks * block_size));
+}
+
+bool cpu_supports_avx2()
+{
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) { return false; }
+    __cpuid(regs, 1);
+    bool const os_uses_xsave = (regs[2] & (1 << 27)) != 0;
+    if (!os_uses_xsave || ((_xgetbv(0) & 0x6) != 0x6)) { return false; }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+}
+
+bool fuel_kernel_supported(FuelKernel kernel)
+{
+    switch (kernel) {
+    case FuelKernel::Scalar: return true;
+#if ADVENT01_HAS_X86_KERNELS
+    case FuelKernel::SSE2: return true;
+    case FuelKernel::AVX2: {
+        static bool const has_avx2 = cpu_supports_avx2();
+        return has_avx2;
+    }
+#endif
+    default: return false;
+    }
+}
+
+FuelKernel best_fuel_kernel()
+{
+    static FuelKernel const best = []() {
+        for (auto const k : { FuelKernel::AVX2, FuelKernel::SSE2 }) {
+            if (fuel_kernel_supported(k)) { return k; }
+        }
+        return FuelKernel::Scalar;
+    }();
+    return best;
+}
+
+std::int64_t total_fuel_batch(std::span<int const> masses)
+{
+    return total_fuel_batch(masses, best_fuel_kernel());
+}
+
+std::int64_t total_fuel_batch(std::span<int const> masses, FuelKernel kernel)
+{
+    assert(fuel_kernel_supported(kernel));
+    switch (kernel) {
+#if ADVENT01_HAS_X86_KERNELS
+    case FuelKernel::SSE2: return total_fuel_sse2(masses);
+    case FuelKernel::AVX2: return total_fuel_avx2(masses);
+#endif
+    default: return total_fuel_scalar(masses);
+    }
+}
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses)
+{
+    return total_fuel_with_fuel_batch(masses, best_fuel_kernel());
+}
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses, FuelKernel kernel)
+{
+    assert(fuel_kernel_supported(kernel));
+    switch (kernel) {
+#if ADVENT01_HAS_X86_KERNELS
+    case FuelKernel::SSE2: return total_fuel_with_fuel_sse2(masses);
+    case FuelKernel::AVX2: return total_fuel_with_fuel_avx2(masses);
+#endif
+    default: return total_fuel_with_fuel_scalar(masses);
+    }
+}
+
+std::size_t parse_masses(std::string_view input, std::vector<int>& masses)
+{
+    std::size_t const last_newline = input.rfind('\n');
+    if (last_newline == std::string_view::npos) { return 0; }
+    char const* it = input.data();
+    char const* const end = input.data() + last_newline + 1;
+    auto const is_space = [](char c) { return (c == '\n') || (c == '\r') || (c == ' ') || (c == '\t'); };
+    while (it != end) {
+        if (is_space(*it)) {
+            ++it;
+            continue;
+        }
+        int mass = 0;
+        auto const [ptr, ec] = std::from_chars(it, end, mass);
+        if (ec == std::errc::result_out_of_range) {
+            throw std::out_of_range("Mass out of range: " + std::string(it, ptr));
+        } else if ((ec != std::errc{}) || (ptr == it) || !is_space(*ptr)) {
+            // the chunk ends in a newline, so ptr is still in range
+            throw std::invalid_argument("Invalid mass in manifest: " + std::string(it, std::find_if(it, end, is_space)));
+        }
+        masses.push_back(mass);
+        it = ptr;
+    }
+    return last_newline + 1;
+}
+
+FuelTotals process_manifest(std::istream& is, std::size_t chunk_size, unsigned n_threads)
+{
+    assert(chunk_size > 0);
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    // together with the chunk each worker is parsing, this keeps at most two chunks per thread in flight
+    std::size_t const max_queued_chunks = n_threads;
+
+    std::mutex mtx;
+    std::condition_variable cv_not_empty;
+    std::condition_variable cv_not_full;
+    std::deque<std::string> queue;
+    bool input_done = false;
+    std::exception_ptr error;       ///< first exception thrown by a worker; stops all processing
+    FuelTotals ret{ 0, 0 };
+
+    auto worker = [&]() {
+        std::vector<int> masses;
+        FuelTotals local{ 0, 0 };
+        for (;;) {
+            std::string chunk;
+            {
+                std::unique_lock lk(mtx);
+                cv_not_empty.wait(lk, [&]() { return !queue.empty() || input_done || error; });
+                if (queue.empty() || error) { break; }
+                chunk = std::move(queue.front());
+                queue.pop_front();
+            }
+            cv_not_full.notify_one();
+            masses.clear();
+            try {
+                if (parse_masses(chunk, masses) != chunk.size()) {
+                    throw std::logic_error("Manifest chunk does not end in a complete line");
+                }
+            } catch (...) {
+                {
+                    std::lock_guard lk(mtx);
+                    if (!error) { error = std::current_exception(); }
+                }
+                cv_not_empty.notify_all();
+                cv_not_full.notify_all();
+                return;
+            }
+            local.fuel += total_fuel_batch(masses);
+            local.fuel_with_fuel += total_fuel_with_fuel_batch(masses);
+        }
+        std::lock_guard lk(mtx);
+        ret.fuel += local.fuel;
+        ret.fuel_with_fuel += local.fuel_with_fuel;
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < n_threads; ++i) { workers.emplace_back(worker); }
+
+    // returns false if a worker has failed and no more input should be read
+    auto push_chunk = [&](std::string&& chunk) {
+        {
+            std::unique_lock lk(mtx);
+            cv_not_full.wait(lk, [&]() { return (queue.size() < max_queued_chunks) || error; });
+            if (error) { return false; }
+            queue.push_back(std::move(chunk));
+        }
+        cv_not_empty.notify_one();
+        return true;
+    };
+
+    // only complete lines are handed to the workers; the remainder carries over into the next chunk
+    std::string buffer;
+    for (;;) {
+        std::size_t const carry = buffer.size();
+        buffer.resize(carry + chunk_size);
+        is.read(buffer.data() + carry, chunk_size);
+        buffer.resize(carry + static_cast<std::size_t>(is.gcount()));
+        if (!is) {
+            if (!buffer.empty() && (buffer.back() != '\n')) { buffer.push_back('\n'); }
+            if (!buffer.empty()) { push_chunk(std::move(buffer)); }
+            break;
+        }
+        std::size_t const last_newline = buffer.rfind('\n');
+        if (last_newline == std::string::npos) { continue; }
+        std::string remainder = buffer.substr(last_newline + 1);
+        buffer.resize(last_newline + 1);
+        if (!push_chunk(std::move(buffer))) { break; }
+        buffer = std::move(remainder);
+    }
+
+    {
+        std::lock_guard lk(mtx);
+        input_done = true;
+    }
+    cv_not_empty.notify_all();
+    for (auto& t : workers) { t.join(); }
+    if (error) { std::rethrow_exception(error); }
+    return ret;
+}
+
+FuelTable::FuelTable(int threshold)
+{
+    assert(threshold > 0);
+    m_table.resize(threshold);
+    for (int mass = 0; mass < threshold; ++mass) {
+        // fuel is always less than mass, so its entry has already been filled in
+        int const fuel = rocket_equation(mass);
+        m_table[mass] = (fuel > 0) ? (fuel + m_table[fuel]) : 0;
+    }
+}
+
+int FuelTable::threshold() const
+{
+    return static_cast<int>(m_table.size());
+}
+
+int FuelTable::fuel_with_fuel(int mass) const
+{
+    int ret = 0;
+    while (mass >= threshold()) {
+        mass = rocket_equation(mass);
+        if (mass <= 0) { return ret; }
+        ret += mass;
+    }
+    return (mass > 0) ? (ret + m_table[mass]) : ret;
+}
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses, FuelTable const& table)
+{
+    std::int64_t ret = 0;
+    for (int const m : masses) { ret += table.fuel_with_fuel(m); }
+    return ret;
+}
+
+MassHistogram make_mass_histogram(std::span<int const> masses)
+{
+    MassHistogram ret;
+    for (int const m : masses) { ++ret[m]; }
+    return ret;
+}
+
+std::int64_t total_fuel(MassHistogram const& histogram)
+{
+    std::int64_t ret = 0;
+    for (auto const& [mass, count] : histogram) { ret += count * rocket_equation(mass); }
+    return ret;
+}
+
+std::int64_t total_fuel_with_fuel(MassHistogram const& histogram, FuelTable const& table)
+{
+    std::int64_t ret = 0;
+    for (auto const& [mass, count] : histogram) { ret += count * table.fuel_with_fuel(mass); }
+    return ret;
+}
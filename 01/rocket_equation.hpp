@@ -1,7 +1,12 @@
 #ifndef ADVENT_OF_CODE_01_ROCKET_EQUATION_HPP_INCLUDE_GUARD
 #define ADVENT_OF_CODE_01_ROCKET_EQUATION_HPP_INCLUDE_GUARD
 
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 std::vector<int> parseInput(std::string_view input);
@@ -14,4 +19,77 @@ int rocket_equation_with_fuel(int mass);
 
 int total_fuel_with_fuel(std::vector<int> const& masses);
 
+enum class FuelKernel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+bool fuel_kernel_supported(FuelKernel kernel);
+
+/** The fastest kernel supported by the executing CPU.
+ */
+FuelKernel best_fuel_kernel();
+
+/** Batch versions of total_fuel() and total_fuel_with_fuel() that accumulate into 64 bits.
+ * The overloads without a kernel argument use best_fuel_kernel().
+ */
+std::int64_t total_fuel_batch(std::span<int const> masses);
+
+std::int64_t total_fuel_batch(std::span<int const> masses, FuelKernel kernel);
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses);
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses, FuelKernel kernel);
+
+/** Appends all masses from a newline-separated list to masses.
+ * Returns the number of characters consumed, which stops short of input.size() if the last line is incomplete.
+ * Only digits, '-' and whitespace are accepted. Throws std::invalid_argument for any other character or a sign
+ * without digits, and std::out_of_range for masses that do not fit an int.
+ */
+std::size_t parse_masses(std::string_view input, std::vector<int>& masses);
+
+struct FuelTotals {
+    std::int64_t fuel;
+    std::int64_t fuel_with_fuel;
+};
+
+/** Computes both fuel totals for a manifest read from is.
+ * Input is read in chunks of roughly chunk_size bytes that are parsed and reduced on n_threads worker threads.
+ * At most 2 * n_threads + 1 chunks are held in memory at any time: one being parsed by each worker,
+ * up to n_threads waiting in the queue, and the one being read.
+ * Passing 0 for n_threads uses the hardware concurrency.
+ * Exceptions from parse_masses() stop processing and are rethrown to the caller.
+ */
+FuelTotals process_manifest(std::istream& is, std::size_t chunk_size = 1 << 20, unsigned n_threads = 0);
+
+/** Lookup table for rocket_equation_with_fuel().
+ * Masses below the threshold are answered from the table. Larger masses apply the rocket equation
+ * until they drop below the threshold, which takes O(log(mass / threshold)) steps.
+ */
+class FuelTable {
+private:
+    std::vector<int> m_table;
+public:
+    explicit FuelTable(int threshold = 1 << 16);
+
+    int threshold() const;
+
+    int fuel_with_fuel(int mass) const;
+};
+
+std::int64_t total_fuel_with_fuel_batch(std::span<int const> masses, FuelTable const& table);
+
+/** Maps each distinct mass to the number of modules with that mass.
+ */
+using MassHistogram = std::unordered_map<int, std::int64_t>;
+
+MassHistogram make_mass_histogram(std::span<int const> masses);
+
+/** Fuel totals over a histogram, evaluating each distinct mass only once.
+ */
+std::int64_t total_fuel(MassHistogram const& histogram);
+
+std::int64_t total_fuel_with_fuel(MassHistogram const& histogram, FuelTable const& table);
+
 #endif
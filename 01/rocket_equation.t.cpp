@@ -2,6 +2,11 @@
 
 #include <catch.hpp>
 
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 TEST_CASE("Rocket Equation")
@@ -39,4 +44,134 @@ TEST_CASE("Rocket Equation")
         std::vector<int> masses{ 12, 14, 1969, 100756 };
         CHECK(total_fuel_with_fuel(masses) == 2 + 2 + 966 + 50346);
     }
+
+    SECTION("Batch Kernels")
+    {
+        std::vector<int> masses{ 12, 14, 1969, 100756, 0, 1, 2, 5, 6, 8, 9, -1, -3, -7, 42, 100, 1000 };
+        std::uint32_t rng = 42;
+        for (int i = 0; i < 1000; ++i) {
+            rng = rng * 1664525u + 1013904223u;
+            masses.push_back(static_cast<int>(rng >> 1) >> (i % 31));
+            if (i % 17 == 0) { masses.back() = -masses.back(); }
+        }
+        masses.push_back(std::numeric_limits<int>::max());
+        masses.push_back(std::numeric_limits<int>::min());
+
+        std::int64_t expected_fuel = 0;
+        std::int64_t expected_fuel_with_fuel = 0;
+        for (auto const m : masses) {
+            expected_fuel += rocket_equation(m);
+            expected_fuel_with_fuel += rocket_equation_with_fuel(m);
+        }
+
+        for (auto const kernel : { FuelKernel::Scalar, FuelKernel::SSE2, FuelKernel::AVX2 }) {
+            if (!fuel_kernel_supported(kernel)) { continue; }
+            // sizes not divisible by the block size exercise the scalar tail
+            for (std::size_t n : { std::size_t{0}, std::size_t{3}, std::size_t{4}, std::size_t{13}, masses.size() }) {
+                std::span<int const> const s(masses.data(), n);
+                std::int64_t fuel = 0;
+                std::int64_t fuel_with_fuel = 0;
+                for (auto const m : s) {
+                    fuel += rocket_equation(m);
+                    fuel_with_fuel += rocket_equation_with_fuel(m);
+                }
+                CHECK(total_fuel_batch(s, kernel) == fuel);
+                CHECK(total_fuel_with_fuel_batch(s, kernel) == fuel_with_fuel);
+            }
+        }
+        CHECK(fuel_kernel_supported(best_fuel_kernel()));
+        CHECK(total_fuel_batch(masses) == expected_fuel);
+        CHECK(total_fuel_with_fuel_batch(masses) == expected_fuel_with_fuel);
+
+        std::vector<int> const heavy(100000, std::numeric_limits<int>::max());
+        CHECK(total_fuel_batch(heavy) == std::int64_t{ 100000 } * rocket_equation(std::numeric_limits<int>::max()));
+        CHECK(total_fuel_with_fuel_batch(heavy) ==
+              std::int64_t{ 100000 } * rocket_equation_with_fuel(std::numeric_limits<int>::max()));
+    }
+
+    SECTION("Parse Masses")
+    {
+        std::vector<int> masses;
+        CHECK(parse_masses("1\n2\n42\n", masses) == 7);
+        CHECK(masses == std::vector<int>{ 1, 2, 42 });
+        CHECK(parse_masses("-5\r\n7\n12", masses) == 6);
+        CHECK(masses == std::vector<int>{ 1, 2, 42, -5, 7 });
+        CHECK(parse_masses("123", masses) == 0);
+        CHECK(masses.size() == 5);
+        CHECK_THROWS_AS(parse_masses("12\n-\n14\n", masses), std::invalid_argument);
+        CHECK_THROWS_AS(parse_masses("99999999999\n", masses), std::out_of_range);
+        CHECK_THROWS_AS(parse_masses("12abc\n", masses), std::invalid_argument);
+        CHECK_THROWS_AS(parse_masses("+5\n", masses), std::invalid_argument);
+        CHECK_THROWS_AS(parse_masses("1-2\n", masses), std::invalid_argument);
+        CHECK_THROWS_AS(parse_masses("x\n", masses), std::invalid_argument);
+        CHECK(parse_masses(" 3 \t\n", masses) == 5);
+        CHECK(masses.back() == 3);
+    }
+
+    SECTION("Streaming Manifest")
+    {
+        std::vector<int> masses;
+        std::string manifest;
+        std::uint32_t rng = 23;
+        for (int i = 0; i < 5000; ++i) {
+            rng = rng * 1664525u + 1013904223u;
+            masses.push_back(static_cast<int>(rng % 1000000));
+            manifest += std::to_string(masses.back()) + "\n";
+        }
+        std::int64_t const expected_fuel = total_fuel_batch(masses);
+        std::int64_t const expected_fuel_with_fuel = total_fuel_with_fuel_batch(masses);
+
+        for (std::size_t chunk_size : { 3, 7, 64, 4096, 1 << 20 }) {
+            for (unsigned n_threads : { 1, 4 }) {
+                std::stringstream sstr(manifest);
+                auto const totals = process_manifest(sstr, chunk_size, n_threads);
+                CHECK(totals.fuel == expected_fuel);
+                CHECK(totals.fuel_with_fuel == expected_fuel_with_fuel);
+            }
+        }
+
+        std::stringstream no_trailing_newline("12\n14\n1969\n100756");
+        auto const totals = process_manifest(no_trailing_newline, 5);
+        CHECK(totals.fuel == 2 + 2 + 654 + 33583);
+        CHECK(totals.fuel_with_fuel == 2 + 2 + 966 + 50346);
+
+        std::stringstream empty;
+        CHECK(process_manifest(empty).fuel == 0);
+
+        for (unsigned n_threads : { 1, 4 }) {
+            std::stringstream invalid(manifest + "-\n" + manifest);
+            CHECK_THROWS_AS(process_manifest(invalid, 64, n_threads), std::invalid_argument);
+            std::stringstream out_of_range("12\n99999999999\n14\n");
+            CHECK_THROWS_AS(process_manifest(out_of_range, 4, n_threads), std::out_of_range);
+            std::stringstream garbage(manifest + "12abc\n" + manifest);
+            CHECK_THROWS_AS(process_manifest(garbage, 64, n_threads), std::invalid_argument);
+        }
+    }
+
+    SECTION("Fuel Table")
+    {
+        FuelTable const table(1000);
+        CHECK(table.threshold() == 1000);
+        for (int mass : { -10, 0, 8, 9, 12, 14, 999, 1000, 1001, 1969, 100756, std::numeric_limits<int>::max() }) {
+            CHECK(table.fuel_with_fuel(mass) == rocket_equation_with_fuel(mass));
+        }
+        for (int mass = 0; mass < 5000; ++mass) {
+            REQUIRE(table.fuel_with_fuel(mass) == rocket_equation_with_fuel(mass));
+        }
+        std::vector<int> const masses{ 12, 14, 1969, 100756 };
+        CHECK(total_fuel_with_fuel_batch(masses, table) == 2 + 2 + 966 + 50346);
+        CHECK(total_fuel_with_fuel_batch(masses, FuelTable{}) == 2 + 2 + 966 + 50346);
+        CHECK(total_fuel_with_fuel_batch(masses, FuelTable{ 1 }) == 2 + 2 + 966 + 50346);
+    }
+
+    SECTION("Mass Histogram")
+    {
+        std::vector<int> masses{ 12, 14, 1969, 100756, 1969, 1969, 12 };
+        auto const histogram = make_mass_histogram(masses);
+        CHECK(histogram.size() == 4);
+        CHECK(histogram.at(1969) == 3);
+        CHECK(histogram.at(12) == 2);
+        CHECK(total_fuel(histogram) == total_fuel_batch(masses));
+        CHECK(total_fuel_with_fuel(histogram, FuelTable{}) == total_fuel_with_fuel_batch(masses));
+    }
 }
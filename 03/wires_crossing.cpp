@@ -4,20 +4,26 @@
 
 #include <wires_crossing.hpp>
 
-#include <range/v3/view/cartesian_product.hpp>
-#include <range/v3/view/drop.hpp>
 #include <range/v3/view/iota.hpp>
-#include <range/v3/view/filter.hpp>
 #include <range/v3/view/split.hpp>
-#include <range/v3/view/transform.hpp>
 #include <range/v3/range/conversion.hpp>
+#include <range/v3/range/primitives.hpp>
 #include <range/v3/algorithm/min_element.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <limits>
+#include <map>
 #include <ostream>
+#include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#   include <immintrin.h>
+#endif
 
 bool operator==(PathSegment const& lhs, PathSegment const& rhs)
 {
@@ -32,12 +38,21 @@ bool operator==(Line const& lhs, Line const& rhs) {
     return (lhs.start == rhs.start) && (lhs.end == rhs.end);
 }
 
+bool operator==(Intersection const& lhs, Intersection const& rhs) {
+    return (lhs.point == rhs.point) && (lhs.line1 == rhs.line1) && (lhs.line2 == rhs.line2);
+}
+
+bool operator==(WireCrossing const& lhs, WireCrossing const& rhs) {
+    return (lhs.point == rhs.point) && (lhs.wire1 == rhs.wire1) && (lhs.line1 == rhs.line1) &&
+           (lhs.wire2 == rhs.wire2) && (lhs.line2 == rhs.line2);
+}
+
 Field parseInput(std::string_view input)
 {
     Field f;
-    int i = 0;
     for (auto const& line : input | ranges::views::split('\n')) {
-        Wire& wire = f.wires[i];
+        if (ranges::empty(line)) { continue; }
+        Wire& wire = f.wires.emplace_back();
         for (auto const& token : line | ranges::views::split(',')) {
             std::string tt = ranges::to<std::string>(token);
             wire.path.emplace_back();
@@ -50,7 +65,6 @@ Field parseInput(std::string_view input)
             }
             l.length = std::stoi(tt.substr(1));
         }
-        ++i;
     }
     return f;
 }
@@ -60,7 +74,9 @@ void layoutWires(Field& f)
     for (int wi : ranges::views::iota(0, static_cast<int>(f.wires.size()))) {
         Wire& w = f.wires[wi];
         w.lines.reserve(w.path.size());
+        w.steps.reserve(w.path.size());
         Coordinates start{ 0, 0 };
+        int steps = 0;
         for (auto const& ps : w.path) {
             Coordinates end = start;
             switch (ps.direction) {
@@ -70,7 +86,9 @@ void layoutWires(Field& f)
             case Direction::Right: end.x += ps.length; break;;
             }
             w.lines.push_back(Line{ start, end });
+            w.steps.push_back(steps);
             start = end;
+            steps += ps.length;
         }
     }
 }
@@ -111,17 +129,291 @@ bool intersect(Line const& l, Coordinates const& p)
     return (p.x >= minx) && (p.x <= maxx) && (p.y >= miny) && (p.y <= maxy);
 }
 
-auto intersectionPoints(std::vector<Line> const& lines1, std::vector<Line> const& lines2)
+std::vector<Intersection> findIntersections(std::vector<Line> const& lines1, std::vector<Line> const& lines2)
+{
+    std::size_t constexpr max_compact_pairs = 1 << 16;
+    if (lines1.size() * lines2.size() <= max_compact_pairs) {
+        auto const s1 = makeSegmentStore(lines1);
+        auto const s2 = makeSegmentStore(lines2);
+        if (s1 && s2) { return findIntersectionsCompact(*s1, *s2); }
+    }
+    return findIntersectionsSweep(lines1, lines2);
+}
+
+std::vector<Intersection> findIntersectionsSweep(std::vector<Line> const& lines1, std::vector<Line> const& lines2)
+{
+    // at equal x, horizontal lines need to be active before and after the vertical lines are checked against them
+    enum class EventType { Insert, Query, Remove };
+    struct Event {
+        int x;
+        EventType type;
+        int wire;
+        int line;
+    };
+    std::array<std::vector<Line> const*, 2> const wires{ &lines1, &lines2 };
+    std::vector<Event> events;
+    for (int wi = 0; wi < 2; ++wi) {
+        auto const& lines = *wires[wi];
+        for (int li = 0; li < static_cast<int>(lines.size()); ++li) {
+            Line const& l = lines[li];
+            if (isVertical(l)) {
+                events.push_back(Event{ l.start.x, EventType::Query, wi, li });
+            } else {
+                auto const [minx, maxx] = std::minmax(l.start.x, l.end.x);
+                events.push_back(Event{ minx, EventType::Insert, wi, li });
+                events.push_back(Event{ maxx, EventType::Remove, wi, li });
+            }
+        }
+    }
+    std::sort(begin(events), end(events), [](Event const& lhs, Event const& rhs) {
+            return std::tie(lhs.x, lhs.type) < std::tie(rhs.x, rhs.type);
+        });
+
+    using ActiveSet = std::multimap<int, int>;
+    std::array<ActiveSet, 2> active;
+    std::array<std::vector<ActiveSet::iterator>, 2> handles;
+    handles[0].resize(lines1.size());
+    handles[1].resize(lines2.size());
+    std::vector<Intersection> ret;
+    for (auto const& e : events) {
+        Line const& l = (*wires[e.wire])[e.line];
+        switch (e.type) {
+        case EventType::Insert:
+            handles[e.wire][e.line] = active[e.wire].emplace(l.start.y, e.line);
+            break;
+        case EventType::Remove:
+            active[e.wire].erase(handles[e.wire][e.line]);
+            break;
+        case EventType::Query: {
+            auto const [miny, maxy] = std::minmax(l.start.y, l.end.y);
+            auto const& other = active[1 - e.wire];
+            for (auto it = other.lower_bound(miny), it_end = other.upper_bound(maxy); it != it_end; ++it) {
+                int const line1 = (e.wire == 0) ? e.line : it->second;
+                int const line2 = (e.wire == 0) ? it->second : e.line;
+                // the two first lines can only meet where both wires start
+                if ((line1 == 0) && (line2 == 0)) { continue; }
+                ret.push_back(Intersection{ Coordinates{ l.start.x, it->first }, line1, line2 });
+            }
+        } break;
+        }
+    }
+    std::sort(begin(ret), end(ret), [](Intersection const& lhs, Intersection const& rhs) {
+            return std::tie(lhs.line1, lhs.line2) < std::tie(rhs.line1, rhs.line2);
+        });
+    return ret;
+}
+
+std::optional<SegmentStore> makeSegmentStore(std::vector<Line> const& lines)
+{
+    auto const fits = [](int i) {
+        return (i >= std::numeric_limits<std::int16_t>::min()) && (i <= std::numeric_limits<std::int16_t>::max());
+    };
+    auto const push = [](SegmentStore::Segments& s, int fixed, int a, int b, int line) {
+        auto const [min, max] = std::minmax(a, b);
+        s.fixed.push_back(static_cast<std::int16_t>(fixed));
+        s.min.push_back(static_cast<std::int16_t>(min));
+        s.max.push_back(static_cast<std::int16_t>(max));
+        s.line.push_back(line);
+    };
+    auto const pad = [](SegmentStore::Segments& s) {
+        while (s.line.size() % SegmentStore::block_size != 0) {
+            s.fixed.push_back(0);
+            s.min.push_back(std::numeric_limits<std::int16_t>::max());
+            s.max.push_back(std::numeric_limits<std::int16_t>::min());
+            s.line.push_back(-1);
+        }
+    };
+    SegmentStore ret;
+    for (int li = 0; li < static_cast<int>(lines.size()); ++li) {
+        Line const& l = lines[li];
+        if (!fits(l.start.x) || !fits(l.start.y) || !fits(l.end.x) || !fits(l.end.y)) { return std::nullopt; }
+        if (isVertical(l)) {
+            push(ret.vertical, l.start.x, l.start.y, l.end.y, li);
+        } else {
+            push(ret.horizontal, l.start.y, l.start.x, l.end.x, li);
+        }
+    }
+    pad(ret.horizontal);
+    pad(ret.vertical);
+    return ret;
+}
+
+namespace {
+/** Calls f with the index of every segment in s that crosses the line at fixed coordinate c covering [min, max].
+ */
+template<typename Func_T>
+void crossingSegments(SegmentStore::Segments const& s, std::int16_t c, std::int16_t min, std::int16_t max, Func_T&& f)
+{
+    std::size_t const n = s.line.size();
+#if defined(__AVX2__)
+    static_assert(SegmentStore::block_size % 16 == 0);
+    __m256i const vc = _mm256_set1_epi16(c);
+    __m256i const vmin = _mm256_set1_epi16(min);
+    __m256i const vmax = _mm256_set1_epi16(max);
+    for (std::size_t i = 0; i < n; i += 16) {
+        __m256i const fixed = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s.fixed.data() + i));
+        __m256i const smin = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s.min.data() + i));
+        __m256i const smax = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s.max.data() + i));
+        __m256i const outside = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi16(vmin, fixed), _mm256_cmpgt_epi16(fixed, vmax)),
+            _mm256_or_si256(_mm256_cmpgt_epi16(smin, vc), _mm256_cmpgt_epi16(vc, smax)));
+        // two mask bits per 16 bit lane
+        std::uint32_t hits = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(outside));
+        for (std::size_t lane = 0; hits != 0; hits >>= 2, ++lane) {
+            if (hits & 1) { f(i + lane); }
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static_assert(SegmentStore::block_size % 8 == 0);
+    __m128i const vc = _mm_set1_epi16(c);
+    __m128i const vmin = _mm_set1_epi16(min);
+    __m128i const vmax = _mm_set1_epi16(max);
+    for (std::size_t i = 0; i < n; i += 8) {
+        __m128i const fixed = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.fixed.data() + i));
+        __m128i const smin = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.min.data() + i));
+        __m128i const smax = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.max.data() + i));
+        __m128i const outside = _mm_or_si128(
+            _mm_or_si128(_mm_cmpgt_epi16(vmin, fixed), _mm_cmpgt_epi16(fixed, vmax)),
+            _mm_or_si128(_mm_cmpgt_epi16(smin, vc), _mm_cmpgt_epi16(vc, smax)));
+        std::uint32_t hits = ~static_cast<std::uint32_t>(_mm_movemask_epi8(outside)) & 0xffff;
+        for (std::size_t lane = 0; hits != 0; hits >>= 2, ++lane) {
+            if (hits & 1) { f(i + lane); }
+        }
+    }
+#else
+    for (std::size_t i = 0; i < n; ++i) {
+        if ((s.fixed[i] >= min) && (s.fixed[i] <= max) && (c >= s.min[i]) && (c <= s.max[i])) { f(i); }
+    }
+#endif
+}
+}
+
+std::vector<Intersection> findIntersectionsCompact(SegmentStore const& s1, SegmentStore const& s2)
+{
+    std::vector<Intersection> ret;
+    // lhs are vertical lines providing x, rhs are horizontal lines providing y
+    auto const cross = [&ret](SegmentStore::Segments const& lhs, SegmentStore::Segments const& rhs, bool lhs_is_first) {
+        for (std::size_t i = 0; i < lhs.line.size(); ++i) {
+            if (lhs.line[i] < 0) { break; }
+            crossingSegments(rhs, lhs.fixed[i], lhs.min[i], lhs.max[i], [&](std::size_t j) {
+                    int const line1 = lhs_is_first ? lhs.line[i] : rhs.line[j];
+                    int const line2 = lhs_is_first ? rhs.line[j] : lhs.line[i];
+                    if ((line1 == 0) && (line2 == 0)) { return; }
+                    ret.push_back(Intersection{ Coordinates{ lhs.fixed[i], rhs.fixed[j] }, line1, line2 });
+                });
+        }
+    };
+    cross(s1.vertical, s2.horizontal, true);
+    cross(s2.vertical, s1.horizontal, false);
+    std::sort(begin(ret), end(ret), [](Intersection const& lhs, Intersection const& rhs) {
+            return std::tie(lhs.line1, lhs.line2) < std::tie(rhs.line1, rhs.line2);
+        });
+    return ret;
+}
+
+std::vector<WireCrossing> findAllIntersections(Field const& f, unsigned n_threads)
 {
-    return ranges::to<std::vector<Coordinates>>(
-        ranges::views::cartesian_product(lines1, lines2) |
-        ranges::views::transform([](auto t) {
-            auto const& [l1, l2] = t;
-            return intersect(l1, l2);
-            }) |
-        ranges::views::drop(1) |
-        ranges::views::filter([](auto opt) { return opt.has_value(); }) |
-        ranges::views::transform([](auto opt) { return *opt; }));
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+
+    enum class EventType { Insert, Query, Remove };
+    struct Event {
+        int x;
+        EventType type;
+        int wire;
+        int line;
+        std::size_t horizontal;     ///< index into horizontals for insert and remove events
+    };
+    // positions of the insert and remove events of a horizontal line in the sorted event list
+    struct HorizontalSpan {
+        std::size_t insert;
+        std::size_t remove;
+    };
+    std::vector<Event> events;
+    std::vector<HorizontalSpan> horizontals;
+    for (int wi = 0; wi < static_cast<int>(f.wires.size()); ++wi) {
+        auto const& lines = f.wires[wi].lines;
+        for (int li = 0; li < static_cast<int>(lines.size()); ++li) {
+            Line const& l = lines[li];
+            if (isVertical(l)) {
+                events.push_back(Event{ l.start.x, EventType::Query, wi, li, 0 });
+            } else {
+                auto const [minx, maxx] = std::minmax(l.start.x, l.end.x);
+                events.push_back(Event{ minx, EventType::Insert, wi, li, horizontals.size() });
+                events.push_back(Event{ maxx, EventType::Remove, wi, li, horizontals.size() });
+                horizontals.emplace_back();
+            }
+        }
+    }
+    std::sort(begin(events), end(events), [](Event const& lhs, Event const& rhs) {
+            return std::tie(lhs.x, lhs.type) < std::tie(rhs.x, rhs.type);
+        });
+    for (std::size_t ei = 0; ei < events.size(); ++ei) {
+        Event const& e = events[ei];
+        if (e.type == EventType::Insert) {
+            horizontals[e.horizontal].insert = ei;
+        } else if (e.type == EventType::Remove) {
+            horizontals[e.horizontal].remove = ei;
+        }
+    }
+
+    // horizontal lines crossing the sweep line, as (y, wire, line)
+    using ActiveSet = std::set<std::tuple<int, int, int>>;
+    auto const apply_update = [&f](ActiveSet& active, Event const& e) {
+        Line const& l = f.wires[e.wire].lines[e.line];
+        if (e.type == EventType::Insert) {
+            active.emplace(l.start.y, e.wire, e.line);
+        } else if (e.type == EventType::Remove) {
+            active.erase(std::make_tuple(l.start.y, e.wire, e.line));
+        }
+    };
+
+    std::size_t const n_slabs = std::max<std::size_t>(std::min<std::size_t>(n_threads, events.size()), 1);
+    std::vector<std::size_t> slab_begin(n_slabs + 1);
+    for (std::size_t si = 0; si <= n_slabs; ++si) { slab_begin[si] = (events.size() * si) / n_slabs; }
+
+    std::vector<std::vector<WireCrossing>> slab_results(n_slabs);
+    auto const process_slab = [&](std::size_t si) {
+        // each slab starts out with the lines that were inserted before and are removed within or after it
+        ActiveSet active;
+        for (HorizontalSpan const& h : horizontals) {
+            if ((h.insert < slab_begin[si]) && (h.remove >= slab_begin[si])) { apply_update(active, events[h.insert]); }
+        }
+        auto& results = slab_results[si];
+        for (std::size_t ei = slab_begin[si]; ei < slab_begin[si + 1]; ++ei) {
+            Event const& e = events[ei];
+            if (e.type != EventType::Query) {
+                apply_update(active, e);
+                continue;
+            }
+            Line const& l = f.wires[e.wire].lines[e.line];
+            auto const [miny, maxy] = std::minmax(l.start.y, l.end.y);
+            auto const it_begin = active.lower_bound(std::make_tuple(miny, std::numeric_limits<int>::min(), 0));
+            auto const it_end = active.upper_bound(std::make_tuple(maxy, std::numeric_limits<int>::max(), 0));
+            for (auto it = it_begin; it != it_end; ++it) {
+                auto const& [y, wire, line] = *it;
+                if (wire == e.wire) { continue; }
+                // the first lines of all wires can only meet where the wires start
+                if ((line == 0) && (e.line == 0)) { continue; }
+                Coordinates const p{ l.start.x, y };
+                if (e.wire < wire) {
+                    results.push_back(WireCrossing{ p, e.wire, e.line, wire, line });
+                } else {
+                    results.push_back(WireCrossing{ p, wire, line, e.wire, e.line });
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t si = 1; si < n_slabs; ++si) { threads.emplace_back(process_slab, si); }
+    process_slab(0);
+    for (auto& t : threads) { t.join(); }
+
+    std::vector<WireCrossing> ret;
+    for (auto& r : slab_results) { ret.insert(ret.end(), r.begin(), r.end()); }
+    std::sort(begin(ret), end(ret), [](WireCrossing const& lhs, WireCrossing const& rhs) {
+            return std::tie(lhs.wire1, lhs.line1, lhs.wire2, lhs.line2) < std::tie(rhs.wire1, rhs.line1, rhs.wire2, rhs.line2);
+        });
+    return ret;
 }
 
 std::tuple<Coordinates, int> closestIntersection(Wire const& w1, Wire const& w2)
@@ -130,40 +422,80 @@ std::tuple<Coordinates, int> closestIntersection(Wire const& w1, Wire const& w2)
         return std::abs(c.x) + std::abs(c.y);
     };
 
-    auto const intersection_points = intersectionPoints(w1.lines, w2.lines);
-    Coordinates const ret = *ranges::min_element(intersection_points,
-        [manhattanDistance](Coordinates const& c1, Coordinates const& c2) {
-            return manhattanDistance(c1) < manhattanDistance(c2);
-        });
+    auto const intersections = findIntersections(w1.lines, w2.lines);
+    Coordinates const ret = ranges::min_element(intersections,
+        [manhattanDistance](Intersection const& i1, Intersection const& i2) {
+            return manhattanDistance(i1.point) < manhattanDistance(i2.point);
+        })->point;
     return std::make_tuple(ret, manhattanDistance(ret));
 }
 
+int stepsTo(Wire const& w, int line_index, Coordinates const& p)
+{
+    assert(w.steps.size() == w.lines.size());
+    Line const& l = w.lines[line_index];
+    assert(intersect(l, p));
+    return w.steps[line_index] + std::abs(l.start.x - p.x) + std::abs(l.start.y - p.y);
+}
+
+namespace {
+/** Steps along w to the first visit of each of the points, in O((n + k) log k) for n lines and k points.
+ * A point is visited by the first line that contains it, which need not be the line that crosses the other wire:
+ * an earlier line may run along the other wire's line through the same point.
+ */
+std::vector<int> firstVisitSteps(Wire const& w, std::vector<Coordinates> const& points)
+{
+    using PointsOnLine = std::set<std::pair<int, std::size_t>>;     // (coordinate along the line, point index)
+    std::map<int, PointsOnLine> by_x;
+    std::map<int, PointsOnLine> by_y;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        by_x[points[i].x].emplace(points[i].y, i);
+        by_y[points[i].y].emplace(points[i].x, i);
+    }
+    std::vector<int> ret(points.size(), -1);
+    for (int line_index = 0; line_index < static_cast<int>(w.lines.size()); ++line_index) {
+        Line const& l = w.lines[line_index];
+        bool const vertical = isVertical(l);
+        auto& along = vertical ? by_x : by_y;
+        auto& across = vertical ? by_y : by_x;
+        int const fixed = vertical ? l.start.x : l.start.y;
+        auto const [min, max] = vertical ? std::minmax(l.start.y, l.end.y) : std::minmax(l.start.x, l.end.x);
+        auto const it_line = along.find(fixed);
+        if (it_line == end(along)) { continue; }
+        // visited points are removed, so that every point is only reported for its first line
+        PointsOnLine& on_line = it_line->second;
+        for (auto it = on_line.lower_bound(std::make_pair(min, std::size_t{ 0 }));
+             (it != end(on_line)) && (it->first <= max); it = on_line.erase(it))
+        {
+            std::size_t const point_index = it->second;
+            ret[point_index] = stepsTo(w, line_index, points[point_index]);
+            across[it->first].erase(std::make_pair(fixed, point_index));
+        }
+    }
+    return ret;
+}
+}
+
 std::array<int, 2> walkIntersectionPoints(Field const& f)
 {
+    assert(f.wires.size() >= 2);
+    auto const intersections = findIntersections(f.wires[0].lines, f.wires[1].lines);
+    // the same point may be reported for several pairs of lines
+    auto const key = [](Coordinates const& c) { return (static_cast<std::int64_t>(c.x) << 32) ^ static_cast<std::uint32_t>(c.y); };
+    std::unordered_map<std::int64_t, std::size_t> point_index;
+    std::vector<Coordinates> points;
+    for (auto const& i : intersections) {
+        if (point_index.emplace(key(i.point), points.size()).second) { points.push_back(i.point); }
+    }
+    std::vector<int> const steps1 = firstVisitSteps(f.wires[0], points);
+    std::vector<int> const steps2 = firstVisitSteps(f.wires[1], points);
+
     std::array<int, 2> ret{ std::numeric_limits<int>::max(), 0};
-    auto const intersection_points = intersectionPoints(f.wires[0].lines, f.wires[1].lines);
-
-    for (auto const& p : intersection_points) {
-        int acc[] = { 0, 0 };
-        for (int i = 0; i < 2; ++i) {
-            auto const& w = f.wires[i];
-            for (auto const& l : w.lines) {
-                if (intersect(l, p)) {
-                    if (isVertical(l)) {
-                        acc[i] += std::abs(l.start.y - p.y);
-                    } else {
-                        acc[i] += std::abs(l.start.x - p.x);
-                    }
-                    break;
-                }
-                acc[i] += length(l);
-            }
-        }
-        if (acc[0] + acc[1] < ret[0] + ret[1]) {
-            ret[0] = acc[0];
-            ret[1] = acc[1];
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        assert((steps1[i] >= 0) && (steps2[i] >= 0));
+        if (steps1[i] + steps2[i] < ret[0] + ret[1]) {
+            ret = { steps1[i], steps2[i] };
         }
     }
     return ret;
 }
-
@@ -2,6 +2,8 @@
 #define ADVENT_OF_CODE_03_WIRES_CROSSING_HPP_INCLUDE_GUARD
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <optional>
 #include <string_view>
@@ -45,10 +47,11 @@ bool intersect(Line const& l, Coordinates const& p);
 struct Wire {
     std::vector<PathSegment> path;
     std::vector<Line> lines;
+    std::vector<int> steps;         ///< steps walked along the wire before reaching the start of each line
 };
 
 struct Field {
-    std::array<Wire, 2> wires;
+    std::vector<Wire> wires;
 };
 
 std::ostream& operator<<(std::ostream & os, Field const& f);
@@ -57,8 +60,75 @@ Field parseInput(std::string_view input);
 
 void layoutWires(Field& f);
 
+struct Intersection {
+    Coordinates point;
+    int line1;
+    int line2;
+};
+
+bool operator==(Intersection const& lhs, Intersection const& rhs);
+
+/** All crossings between a line from lines1 and a line from lines2, except for the common starting point.
+ * Results are ordered by line1, then line2.
+ * Small inputs are handled by findIntersectionsCompact(), everything else by findIntersectionsSweep().
+ */
+std::vector<Intersection> findIntersections(std::vector<Line> const& lines1, std::vector<Line> const& lines2);
+
+/** Same as findIntersections(), using a sweep over x with the horizontal lines currently crossing
+ * the sweep line ordered by y, for O((n + m) log(n + m) + k).
+ */
+std::vector<Intersection> findIntersectionsSweep(std::vector<Line> const& lines1, std::vector<Line> const& lines2);
+
+/** Lines of a wire in structure-of-arrays layout with 16 bit coordinates, split by orientation.
+ * Each line is stored as its fixed coordinate and the range it covers along the other axis.
+ * Both sets are padded to a multiple of SegmentStore::block_size with lines that never intersect anything.
+ */
+struct SegmentStore {
+    static constexpr std::size_t block_size = 16;
+
+    struct Segments {
+        std::vector<std::int16_t> fixed;
+        std::vector<std::int16_t> min;
+        std::vector<std::int16_t> max;
+        std::vector<int> line;          ///< index into the original lines, -1 for padding
+    };
+    Segments horizontal;            ///< fixed coordinate is y
+    Segments vertical;              ///< fixed coordinate is x
+};
+
+/** Returns std::nullopt if a coordinate does not fit into 16 bits.
+ */
+std::optional<SegmentStore> makeSegmentStore(std::vector<Line> const& lines);
+
+/** Same as findIntersections(), testing each line against blocks of opposing lines with SIMD compares.
+ * This is O(n * m), but beats the sweep for small inputs.
+ */
+std::vector<Intersection> findIntersectionsCompact(SegmentStore const& s1, SegmentStore const& s2);
+
 std::tuple<Coordinates, int> closestIntersection(Wire const& w1, Wire const& w2);
 
+struct WireCrossing {
+    Coordinates point;
+    int wire1;
+    int line1;
+    int wire2;
+    int line2;
+};
+
+bool operator==(WireCrossing const& lhs, WireCrossing const& rhs);
+
+/** All crossings between lines of different wires in f, except for the common starting point.
+ * Builds one sweep over all wires and splits it into slabs along x that are processed on n_threads threads.
+ * Each thread also builds the starting state of its slab from the horizontal lines that span the slab boundary.
+ * Passing 0 for n_threads uses the hardware concurrency.
+ * Results are ordered by wire1, line1, wire2, line2, with wire1 < wire2.
+ */
+std::vector<WireCrossing> findAllIntersections(Field const& f, unsigned n_threads = 0);
+
+/** Steps walked along w to reach p, which has to lie on the line with the given index.
+ */
+int stepsTo(Wire const& w, int line_index, Coordinates const& p);
+
 std::array<int, 2> walkIntersectionPoints(Field const& f);
 
 #endif
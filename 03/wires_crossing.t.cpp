@@ -2,7 +2,11 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <tuple>
 #include <vector>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -66,6 +70,20 @@ TEST_CASE("Wires Crossing")
         CHECK(field.wires[1].lines[1] == Line{ {0, 7}, {6, 7} });
         CHECK(field.wires[1].lines[2] == Line{ {6, 7}, {6, 3} });
         CHECK(field.wires[1].lines[3] == Line{ {6, 3}, {2, 3} });
+
+        CHECK(field.wires[0].steps == std::vector<int>{ 0, 8, 13, 18 });
+        CHECK(field.wires[1].steps == std::vector<int>{ 0, 7, 13, 17 });
+    }
+
+    SECTION("Steps To Point")
+    {
+        Field field = parseInput(sample_input);
+        layoutWires(field);
+        CHECK(stepsTo(field.wires[0], 0, Coordinates{ 0, 0 }) == 0);
+        CHECK(stepsTo(field.wires[0], 2, Coordinates{ 6, 5 }) == 15);
+        CHECK(stepsTo(field.wires[0], 3, Coordinates{ 3, 3 }) == 20);
+        CHECK(stepsTo(field.wires[1], 2, Coordinates{ 6, 5 }) == 15);
+        CHECK(stepsTo(field.wires[1], 3, Coordinates{ 3, 3 }) == 20);
     }
 
     SECTION("Line Is Vertical")
@@ -149,5 +167,150 @@ TEST_CASE("Wires Crossing")
         auto const steps3 = walkIntersectionPoints(field3);
         CHECK(steps3 == std::array<int, 2>{154, 256});
         CHECK(steps3[0] + steps3[1] == 410);
+
+        // the first wire reaches the crossing at 0,5 earlier along a line that overlaps the second wire
+        Field field4 = parseInput("U7,R3,D2,L6\nU10");
+        layoutWires(field4);
+        CHECK(walkIntersectionPoints(field4) == std::array<int, 2>{5, 5});
+    }
+
+    SECTION("Find Intersections")
+    {
+        auto const brute_force = [](std::vector<Line> const& lines1, std::vector<Line> const& lines2) {
+            std::vector<Intersection> ret;
+            for (int i1 = 0; i1 < static_cast<int>(lines1.size()); ++i1) {
+                for (int i2 = 0; i2 < static_cast<int>(lines2.size()); ++i2) {
+                    if ((i1 == 0) && (i2 == 0)) { continue; }
+                    if (auto const p = intersect(lines1[i1], lines2[i2]); p) {
+                        ret.push_back(Intersection{ *p, i1, i2 });
+                    }
+                }
+            }
+            return ret;
+        };
+
+        Field field = parseInput(sample_input);
+        layoutWires(field);
+        CHECK(findIntersections(field.wires[0].lines, field.wires[1].lines) ==
+              std::vector<Intersection>{ { { 6, 5 }, 2, 2 }, { { 3, 3 }, 3, 3 } });
+
+        for (auto const& input : { sample_input2, sample_input3 }) {
+            Field f = parseInput(input);
+            layoutWires(f);
+            CHECK(findIntersections(f.wires[0].lines, f.wires[1].lines) ==
+                  brute_force(f.wires[0].lines, f.wires[1].lines));
+        }
+
+        // random walks with many crossings, touching endpoints and overlapping parallel lines
+        std::uint32_t rng = 42;
+        auto const random_wire = [&rng]() {
+            std::string ret;
+            for (int i = 0; i < 300; ++i) {
+                rng = rng * 1664525u + 1013904223u;
+                if (i != 0) { ret += ','; }
+                ret += "UDLR"[(rng >> 8) % 4];
+                ret += std::to_string((rng >> 16) % 20 + 1);
+            }
+            return ret;
+        };
+        Field random_field = parseInput(random_wire() + "\n" + random_wire());
+        layoutWires(random_field);
+        auto const random_intersections = findIntersections(random_field.wires[0].lines, random_field.wires[1].lines);
+        CHECK(!random_intersections.empty());
+        CHECK(random_intersections == brute_force(random_field.wires[0].lines, random_field.wires[1].lines));
+        CHECK(findIntersectionsSweep(random_field.wires[0].lines, random_field.wires[1].lines) == random_intersections);
+        auto const s1 = makeSegmentStore(random_field.wires[0].lines);
+        auto const s2 = makeSegmentStore(random_field.wires[1].lines);
+        REQUIRE(s1);
+        REQUIRE(s2);
+        CHECK(findIntersectionsCompact(*s1, *s2) == random_intersections);
+
+        // walking the wires from the start has to agree with the step index
+        auto const walk = [](Wire const& w, Coordinates const& p) {
+            int acc = 0;
+            for (auto const& l : w.lines) {
+                if (intersect(l, p)) { return acc + std::abs(l.start.x - p.x) + std::abs(l.start.y - p.y); }
+                acc += length(l);
+            }
+            return -1;
+        };
+        std::array<int, 2> expected_steps{ std::numeric_limits<int>::max(), 0 };
+        for (auto const& i : random_intersections) {
+            std::array<int, 2> const acc{ walk(random_field.wires[0], i.point), walk(random_field.wires[1], i.point) };
+            if (acc[0] + acc[1] < expected_steps[0] + expected_steps[1]) { expected_steps = acc; }
+        }
+        CHECK(walkIntersectionPoints(random_field) == expected_steps);
+    }
+
+    SECTION("Parse Input Multiple Wires")
+    {
+        Field const field = parseInput("R8,U5\nU7,R6\nL2\n");
+        REQUIRE(field.wires.size() == 3);
+        CHECK(field.wires[2].path == std::vector<PathSegment>{ { Direction::Left, 2 } });
+    }
+
+    SECTION("Find All Intersections")
+    {
+        std::string const input = std::string(sample_input2) + "\n" + sample_input3 + "\n" + sample_input;
+        Field field = parseInput(input);
+        layoutWires(field);
+        REQUIRE(field.wires.size() == 6);
+
+        std::vector<WireCrossing> expected;
+        for (int w1 = 0; w1 < 6; ++w1) {
+            for (int w2 = w1 + 1; w2 < 6; ++w2) {
+                for (auto const& i : findIntersections(field.wires[w1].lines, field.wires[w2].lines)) {
+                    expected.push_back(WireCrossing{ i.point, w1, i.line1, w2, i.line2 });
+                }
+            }
+        }
+        std::sort(begin(expected), end(expected), [](WireCrossing const& lhs, WireCrossing const& rhs) {
+                return std::tie(lhs.wire1, lhs.line1, lhs.wire2, lhs.line2) < std::tie(rhs.wire1, rhs.line1, rhs.wire2, rhs.line2);
+            });
+        REQUIRE(!expected.empty());
+        for (unsigned n_threads : { 1, 2, 3, 8, 1000 }) {
+            CHECK(findAllIntersections(field, n_threads) == expected);
+        }
+        CHECK(findAllIntersections(field) == expected);
+        CHECK(findAllIntersections(Field{}).empty());
+    }
+
+    SECTION("Segment Store")
+    {
+        Field field = parseInput(sample_input);
+        layoutWires(field);
+        auto const s = makeSegmentStore(field.wires[0].lines);
+        REQUIRE(s);
+        REQUIRE(s->horizontal.line.size() == SegmentStore::block_size);
+        REQUIRE(s->vertical.line.size() == SegmentStore::block_size);
+        CHECK(s->horizontal.line[0] == 0);
+        CHECK(s->horizontal.fixed[0] == 0);
+        CHECK(s->horizontal.min[0] == 0);
+        CHECK(s->horizontal.max[0] == 8);
+        CHECK(s->horizontal.line[1] == 2);
+        CHECK(s->horizontal.fixed[1] == 5);
+        CHECK(s->horizontal.min[1] == 3);
+        CHECK(s->horizontal.max[1] == 8);
+        CHECK(s->horizontal.line[2] == -1);
+        CHECK(s->vertical.line[0] == 1);
+        CHECK(s->vertical.fixed[0] == 8);
+        CHECK(s->vertical.min[0] == 0);
+        CHECK(s->vertical.max[0] == 5);
+        CHECK(s->vertical.line[1] == 3);
+        CHECK(s->vertical.line[2] == -1);
+
+        CHECK_FALSE(makeSegmentStore(std::vector<Line>{ Line{ { 0, 0 }, { 40000, 0 } } }));
+        CHECK(makeSegmentStore(std::vector<Line>{ Line{ { 0, -32768 }, { 0, 32767 } } }));
+
+        // lines touching the limits of the 16 bit range do not hit the padding
+        std::vector<Line> const l1{ Line{ { 0, 100 }, { 1, 100 } },
+                                    Line{ { -32768, 0 }, { -32768, 5 } }, Line{ { 32767, 5 }, { 32767, 0 } } };
+        std::vector<Line> const l2{ Line{ { 32767, 1 }, { -32768, 1 } } };
+        auto const s1 = makeSegmentStore(l1);
+        auto const s2 = makeSegmentStore(l2);
+        CHECK(findIntersectionsCompact(*s1, *s2) ==
+              std::vector<Intersection>{ { { -32768, 1 }, 1, 0 }, { { 32767, 1 }, 2, 0 } });
+        CHECK(findIntersectionsCompact(*s2, *s1) ==
+              std::vector<Intersection>{ { { -32768, 1 }, 0, 1 }, { { 32767, 1 }, 0, 2 } });
     }
 }
@@ -37,12 +37,9 @@ int main(int argc, char* argv[])
     }
 
     InputRange const ir = parseInput(*input);
-    auto const passwords = generateValidPasswords(ir);
+    std::cout << "First result is " << countValidPasswords(ir) << std::endl;
 
-    std::cout << "First result is " << passwords.size() << std::endl;
-
-    auto const passwords2 = generateValidPasswords2(ir);
-    std::cout << "Second result is " << passwords2.size() << std::endl;
+    std::cout << "Second result is " << countValidPasswords2(ir) << std::endl;
 
     return 0;
 }
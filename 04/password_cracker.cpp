@@ -2,14 +2,41 @@
 
 #include <range/v3/algorithm/adjacent_find.hpp>
 #include <range/v3/range/access.hpp>
-#include <range/v3/range/conversion.hpp>
-#include <range/v3/view/iota.hpp>
-#include <range/v3/view/filter.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+
+namespace {
+std::int64_t powerOf10(int exponent)
+{
+    std::int64_t ret = 1;
+    for (int i = 0; i < exponent; ++i) { ret *= 10; }
+    return ret;
+}
+
+void checkDigitCount(int n_digits)
+{
+    if ((n_digits <= 0) || (n_digits > max_password_digits)) {
+        throw std::invalid_argument("Passwords need between 1 and " + std::to_string(max_password_digits) + " digits");
+    }
+}
+
+/** Throws unless both bounds fit into r.n_digits digits. An empty range, with lower > upper, is valid.
+ */
+void checkPasswordRange(PasswordRange const& r)
+{
+    checkDigitCount(r.n_digits);
+    if ((r.lower < 0) || (r.upper < 0) || (r.lower >= powerOf10(r.n_digits)) || (r.upper >= powerOf10(r.n_digits))) {
+        throw std::invalid_argument("Password range exceeds its digits");
+    }
+}
+}
 
 InputRange parseInput(std::string_view input)
 {
@@ -20,29 +47,48 @@ InputRange parseInput(std::string_view input)
     return ret;
 }
 
+PasswordRange parsePasswordRange(std::string_view input)
+{
+    auto separator = input.find('-');
+    if (separator == std::string_view::npos) { throw std::invalid_argument("Missing '-' in password range"); }
+    std::string_view const upper = input.substr(separator + 1);
+    PasswordRange ret;
+    ret.lower = std::stoll(std::string(input.substr(0, separator)));
+    ret.upper = std::stoll(std::string(upper));
+    ret.n_digits = static_cast<int>(std::count_if(upper.begin(), upper.end(), [](char c) { return (c >= '0') && (c <= '9'); }));
+    checkPasswordRange(ret);
+    if (ret.lower > ret.upper) { throw std::invalid_argument("Lower bound of password range exceeds upper bound"); }
+    return ret;
+}
+
 Digits getDigits(int n)
 {
     Digits ret;
-    int divider = 1;
-    for (int i = 0; i < 6; ++i) {
-        ret[5 - i] = (n / divider) % 10;
-        divider *= 10;
-    }
-    assert((n / divider) == 0);
+    getDigits(n, ret);
     return ret;
 }
 
-bool hasAdjacentDigits(Digits const& digits)
+void getDigits(std::int64_t n, std::span<int> digits)
+{
+    assert(n >= 0);
+    for (std::size_t i = digits.size(); i > 0; --i) {
+        digits[i - 1] = static_cast<int>(n % 10);
+        n /= 10;
+    }
+    assert(n == 0);
+}
+
+bool hasAdjacentDigits(std::span<int const> digits)
 {
     return ranges::adjacent_find(digits) != ranges::end(digits);
 }
 
-bool isIncreasing(Digits const& digits)
+bool isIncreasing(std::span<int const> digits)
 {
     return ranges::adjacent_find(digits, std::greater{}) == ranges::end(digits);
 }
 
-bool hasDouble(Digits const& digits)
+bool hasDouble(std::span<int const> digits)
 {
     auto it = begin(digits);
     while (it != end(digits)) {
@@ -68,11 +114,124 @@ bool isValidPassword(int password)
     return isIncreasing(digits) && hasAdjacentDigits(digits);
 }
 
+bool satisfiesRule(std::span<int const> digits, PasswordRule rule)
+{
+    return isIncreasing(digits) && ((rule == PasswordRule::AdjacentPair) ? hasAdjacentDigits(digits) : hasDouble(digits));
+}
+
+namespace {
+/** Counts the valid passwords in [0, bound].
+ * Walks the digits from the most significant one, tracking the last digit, the length of the
+ * current group of equal digits (capped at 3) and whether a qualifying group was already seen.
+ * Only prefixes that still equal the bound have to be enumerated; all others are memoized.
+ */
+std::int64_t countUpTo(std::int64_t bound, int n_digits, PasswordRule rule)
+{
+    if (bound < 0) { return 0; }
+    bool const exact_double = (rule == PasswordRule::ExactDouble);
+    std::array<int, max_password_digits> bound_digits;
+    getDigits(bound, std::span<int>(bound_digits.data(), n_digits));
+    std::array<std::array<std::array<std::array<std::int64_t, 2>, 4>, 10>, max_password_digits> memo;
+    for (auto& m1 : memo) { for (auto& m2 : m1) { for (auto& m3 : m2) { m3.fill(-1); } } }
+
+    auto count = [&](auto& self, int pos, int last, int run, bool found, bool tight) -> std::int64_t {
+        if (pos == n_digits) {
+            return (found || (exact_double && (run == 2))) ? 1 : 0;
+        }
+        if (!tight && (memo[pos][last][run][found] >= 0)) { return memo[pos][last][run][found]; }
+        int const max_digit = tight ? bound_digits[pos] : 9;
+        std::int64_t ret = 0;
+        for (int d = last; d <= max_digit; ++d) {
+            bool new_found = found;
+            int new_run = 1;
+            if ((run > 0) && (d == last)) {
+                new_run = std::min(run + 1, 3);
+            } else if (exact_double && (run == 2)) {
+                // a group of exactly two just ended
+                new_found = true;
+            }
+            if (!exact_double && (new_run >= 2)) { new_found = true; }
+            ret += self(self, pos + 1, d, new_run, new_found, tight && (d == max_digit));
+        }
+        if (!tight) { memo[pos][last][run][found] = ret; }
+        return ret;
+    };
+    return count(count, 0, 0, 0, false, true);
+}
+}
+
+NonDecreasingPasswords::NonDecreasingPasswords(PasswordRange r)
+    :m_range(r), m_digits{}, m_value(-1)
+{
+    checkPasswordRange(r);
+}
+
+bool NonDecreasingPasswords::next()
+{
+    auto const digits = std::span<int>(m_digits.data(), m_range.n_digits);
+    if (m_value < 0) {
+        if (m_range.lower > m_range.upper) { return false; }
+        m_value = nextNonDecreasing(m_range.lower, m_range.n_digits);
+        getDigits(m_value, digits);
+    } else {
+        // bump the last digit that is not a 9 and repeat it for all following digits
+        auto const it = std::find_if(digits.rbegin(), digits.rend(), [](int d) { return d != 9; });
+        if (it == digits.rend()) { m_value = m_range.upper + 1; return false; }
+        int const d = ++(*it);
+        std::fill(it.base(), digits.end(), d);
+        m_value = 0;
+        for (int const dd : digits) { m_value = m_value * 10 + dd; }
+    }
+    return m_value <= m_range.upper;
+}
+
+std::int64_t NonDecreasingPasswords::value() const
+{
+    return m_value;
+}
+
+std::span<int const> NonDecreasingPasswords::digits() const
+{
+    return std::span<int const>(m_digits.data(), m_range.n_digits);
+}
+
+int nextNonDecreasing(int n)
+{
+    return static_cast<int>(nextNonDecreasing(n, std::tuple_size_v<Digits>));
+}
+
+std::int64_t nextNonDecreasing(std::int64_t n, int n_digits)
+{
+    checkPasswordRange(PasswordRange{ n, n, n_digits });
+    std::array<int, max_password_digits> buffer;
+    auto const digits = std::span<int>(buffer.data(), n_digits);
+    getDigits(n, digits);
+    for (std::size_t i = 1; i < digits.size(); ++i) {
+        if (digits[i] < digits[i - 1]) {
+            std::fill(digits.begin() + i, digits.end(), digits[i - 1]);
+            break;
+        }
+    }
+    std::int64_t ret = 0;
+    for (int const d : digits) { ret = ret * 10 + d; }
+    return ret;
+}
+
+namespace {
+std::vector<int> generateValidPasswords(InputRange r, PasswordRule rule)
+{
+    std::vector<int> ret;
+    NonDecreasingPasswords candidates(PasswordRange{ r.lower, r.upper, std::tuple_size_v<Digits> });
+    while (candidates.next()) {
+        if (satisfiesRule(candidates.digits(), rule)) { ret.push_back(static_cast<int>(candidates.value())); }
+    }
+    return ret;
+}
+}
+
 std::vector<int> generateValidPasswords(InputRange r)
 {
-    return ranges::to<std::vector<int>>(
-        ranges::views::iota(r.lower, r.upper + 1) |
-        ranges::views::filter(isValidPassword));
+    return generateValidPasswords(r, PasswordRule::AdjacentPair);
 }
 
 bool isValidPassword2(int password)
@@ -83,8 +242,164 @@ bool isValidPassword2(int password)
 
 std::vector<int> generateValidPasswords2(InputRange r)
 {
-    return ranges::to<std::vector<int>>(
-        ranges::views::iota(r.lower, r.upper + 1) |
-        ranges::views::filter(isValidPassword2));
+    return generateValidPasswords(r, PasswordRule::ExactDouble);
+}
+
+std::int64_t countValidPasswords(InputRange r)
+{
+    return countValidPasswords(PasswordRange{ r.lower, r.upper, std::tuple_size_v<Digits> }, PasswordRule::AdjacentPair);
+}
+
+std::int64_t countValidPasswords2(InputRange r)
+{
+    return countValidPasswords(PasswordRange{ r.lower, r.upper, std::tuple_size_v<Digits> }, PasswordRule::ExactDouble);
+}
+
+std::int64_t countValidPasswords(PasswordRange r, PasswordRule rule)
+{
+    checkPasswordRange(r);
+    if (r.lower > r.upper) { return 0; }
+    return countUpTo(r.upper, r.n_digits, rule) - countUpTo(r.lower - 1, r.n_digits, rule);
+}
+
+namespace {
+std::uint32_t constexpr low_part_modulus = 1'000'000'000;
+int constexpr low_part_digits = 9;
+
+/** Lane-parallel rule check over digits laid out as digits[position][lane].
+ * The loops over lanes have a fixed trip count and no branches, so that they compile to vector code.
+ */
+template<PasswordRule Rule_T>
+unsigned checkLanes(std::array<std::array<std::uint32_t, password_lanes>, max_password_digits> const& digits, int n_digits)
+{
+    std::array<std::uint8_t, password_lanes> monotone;
+    std::array<std::uint8_t, password_lanes> found;
+    std::array<std::uint8_t, password_lanes> prev_equal;
+    monotone.fill(1);
+    found.fill(0);
+    prev_equal.fill(0);
+    for (int pos = 0; pos + 1 < n_digits; ++pos) {
+        auto const& d0 = digits[pos];
+        auto const& d1 = digits[pos + 1];
+        for (std::size_t l = 0; l < password_lanes; ++l) {
+            std::uint8_t const equal = (d0[l] == d1[l]);
+            monotone[l] &= (d0[l] <= d1[l]);
+            if constexpr (Rule_T == PasswordRule::AdjacentPair) {
+                found[l] |= equal;
+            } else {
+                std::uint8_t const next_equal = (pos + 2 < n_digits) && (d1[l] == digits[pos + 2][l]);
+                found[l] |= equal & !prev_equal[l] & !next_equal;
+                prev_equal[l] = equal;
+            }
+        }
+    }
+    unsigned ret = 0;
+    for (std::size_t l = 0; l < password_lanes; ++l) {
+        ret |= static_cast<unsigned>(monotone[l] & found[l]) << l;
+    }
+    return ret;
+}
+
+template<typename Func_T>
+void validateRangeParallel(PasswordRange r, PasswordRule rule, unsigned n_threads, Func_T&& on_chunk_result)
+{
+    checkPasswordRange(r);
+    if (r.lower > r.upper) { return; }
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    std::int64_t const width = r.upper - r.lower + 1;
+    std::int64_t constexpr min_chunk_size = 1 << 16;
+    std::int64_t const n_chunks = std::clamp<std::int64_t>(width / min_chunk_size, 1, 8 * n_threads);
+    std::atomic<std::int64_t> next_chunk = 0;
+
+    auto const worker = [&]() {
+        std::vector<std::int64_t> matches;
+        std::array<int, max_password_digits> digits;
+        auto const scalar_digits = std::span<int>(digits.data(), r.n_digits);
+        for (std::int64_t chunk = next_chunk++; chunk < n_chunks; chunk = next_chunk++) {
+            std::int64_t const chunk_lower = r.lower + (width / n_chunks) * chunk + std::min(chunk, width % n_chunks);
+            std::int64_t const chunk_upper = chunk_lower + (width / n_chunks) + ((chunk < width % n_chunks) ? 1 : 0) - 1;
+            matches.clear();
+            std::int64_t n = chunk_lower;
+            while (n <= chunk_upper) {
+                bool const fits_block = (n + static_cast<std::int64_t>(password_lanes) - 1 <= chunk_upper) &&
+                    ((n % low_part_modulus) + password_lanes <= low_part_modulus);
+                if (fits_block) {
+                    unsigned mask = validatePasswordBlock(n, r.n_digits, rule);
+                    for (std::size_t l = 0; mask != 0; ++l, mask >>= 1) {
+                        if (mask & 1) { matches.push_back(n + static_cast<std::int64_t>(l)); }
+                    }
+                    n += password_lanes;
+                } else {
+                    getDigits(n, scalar_digits);
+                    if (satisfiesRule(scalar_digits, rule)) { matches.push_back(n); }
+                    ++n;
+                }
+            }
+            on_chunk_result(chunk, n_chunks, matches);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::min<std::int64_t>(n_threads, n_chunks); ++i) { threads.emplace_back(worker); }
+    worker();
+    for (auto& t : threads) { t.join(); }
+}
+}
+
+unsigned validatePasswordBlock(std::int64_t base, int n_digits, PasswordRule rule)
+{
+    if ((n_digits <= 0) || (n_digits > max_password_digits) || (base < 0)) {
+        throw std::invalid_argument("Invalid password block");
+    }
+    // all lanes have to fit into n_digits, and their low part must not carry into the high digits
+    std::uint32_t const low = static_cast<std::uint32_t>(base % low_part_modulus);
+    if ((base + static_cast<std::int64_t>(password_lanes) > powerOf10(n_digits)) ||
+        (low + password_lanes > low_part_modulus))
+    {
+        throw std::out_of_range("Password block exceeds its digits");
+    }
+    int const n_high_digits = std::max(n_digits - low_part_digits, 0);
+
+    std::array<std::array<std::uint32_t, password_lanes>, max_password_digits> digits;
+    // digits above the low part are the same for all lanes
+    std::int64_t high = base / low_part_modulus;
+    for (int pos = n_high_digits - 1; pos >= 0; --pos) {
+        digits[pos].fill(static_cast<std::uint32_t>(high % 10));
+        high /= 10;
+    }
+    assert(high == 0);
+    std::array<std::uint32_t, password_lanes> values;
+    for (std::size_t l = 0; l < password_lanes; ++l) { values[l] = low + static_cast<std::uint32_t>(l); }
+    for (int pos = n_digits - 1; pos >= n_high_digits; --pos) {
+        auto& d = digits[pos];
+        for (std::size_t l = 0; l < password_lanes; ++l) {
+            d[l] = values[l] % 10;
+            values[l] /= 10;
+        }
+    }
+    return (rule == PasswordRule::AdjacentPair) ? checkLanes<PasswordRule::AdjacentPair>(digits, n_digits) :
+                                                  checkLanes<PasswordRule::ExactDouble>(digits, n_digits);
 }
 
+std::int64_t countValidPasswordsParallel(PasswordRange r, PasswordRule rule, unsigned n_threads)
+{
+    std::atomic<std::int64_t> ret = 0;
+    validateRangeParallel(r, rule, n_threads, [&ret](std::int64_t, std::int64_t, std::vector<std::int64_t> const& matches) {
+            ret += static_cast<std::int64_t>(matches.size());
+        });
+    return ret;
+}
+
+std::vector<std::int64_t> findValidPasswordsParallel(PasswordRange r, PasswordRule rule, unsigned n_threads)
+{
+    std::vector<std::vector<std::int64_t>> chunk_results;
+    std::mutex mtx;
+    validateRangeParallel(r, rule, n_threads,
+        [&chunk_results, &mtx](std::int64_t chunk, std::int64_t n_chunks, std::vector<std::int64_t> const& matches) {
+            std::lock_guard lk(mtx);
+            chunk_results.resize(n_chunks);
+            chunk_results[chunk] = matches;
+        });
+    std::vector<std::int64_t> ret;
+    for (auto const& c : chunk_results) { ret.insert(ret.end(), c.begin(), c.end()); }
+    return ret;
+}
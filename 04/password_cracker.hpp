@@ -2,6 +2,9 @@
 #define ADVENT_OF_CODE_04_PASSWORD_CRACKING_HPP_INCLUDE_GUARD
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -16,11 +19,11 @@ InputRange parseInput(std::string_view input);
 
 Digits getDigits(int n);
 
-bool hasAdjacentDigits(Digits const& digits);
+bool hasAdjacentDigits(std::span<int const> digits);
 
-bool isIncreasing(Digits const& digits);
+bool isIncreasing(std::span<int const> digits);
 
-bool hasDouble(Digits const& digits);
+bool hasDouble(std::span<int const> digits);
 
 bool isValidPassword(int password);
 
@@ -30,4 +33,87 @@ bool isValidPassword2(int password);
 
 std::vector<int> generateValidPasswords2(InputRange r);
 
+/** Smallest number >= n whose digits do not decrease.
+ */
+int nextNonDecreasing(int n);
+
+/** Number of valid passwords in r, counted by dynamic programming over the digits instead of enumeration.
+ */
+std::int64_t countValidPasswords(InputRange r);
+
+std::int64_t countValidPasswords2(InputRange r);
+
+/* Passwords with up to max_password_digits digits */
+
+int constexpr max_password_digits = 18;
+
+/** Functions taking a PasswordRange throw std::invalid_argument if n_digits is not in [1, max_password_digits]
+ * or a bound does not fit into n_digits digits. A range with lower > upper is empty.
+ */
+struct PasswordRange {
+    std::int64_t lower;
+    std::int64_t upper;
+    int n_digits;           ///< numbers are checked as exactly this many digits, padded with leading zeros
+};
+
+enum class PasswordRule {
+    AdjacentPair,           ///< rules from part one
+    ExactDouble             ///< rules from part two
+};
+
+/** Parses a range like parseInput(), taking the number of digits from the upper bound.
+ * Throws std::invalid_argument if the upper bound has more than max_password_digits digits or if lower > upper.
+ */
+PasswordRange parsePasswordRange(std::string_view input);
+
+/** Writes the last digits.size() digits of n to digits, most significant first.
+ */
+void getDigits(std::int64_t n, std::span<int> digits);
+
+bool satisfiesRule(std::span<int const> digits, PasswordRule rule);
+
+std::int64_t nextNonDecreasing(std::int64_t n, int n_digits);
+
+std::int64_t countValidPasswords(PasswordRange r, PasswordRule rule);
+
+/** Brute-force validation of every number in r, for rule sets that cannot be counted by countValidPasswords().
+ * The range is split into chunks that are processed on n_threads threads. Within a chunk, blocks of
+ * password_lanes consecutive candidates have their digits extracted and checked side by side.
+ * Passing 0 for n_threads uses the hardware concurrency.
+ */
+std::int64_t countValidPasswordsParallel(PasswordRange r, PasswordRule rule, unsigned n_threads = 0);
+
+/** Same as countValidPasswordsParallel(), returning all valid passwords in ascending order.
+ */
+std::vector<std::int64_t> findValidPasswordsParallel(PasswordRange r, PasswordRule rule, unsigned n_threads = 0);
+
+std::size_t constexpr password_lanes = 8;
+
+/** Checks the password_lanes consecutive numbers starting at base.
+ * Bit i of the result is set if base + i is valid. All lanes must fit into n_digits and the low 9 digits
+ * of all lanes must not carry over, that is (base % 10^9) + password_lanes <= 10^9. Otherwise, or if
+ * n_digits is not in [1, max_password_digits], throws.
+ */
+unsigned validatePasswordBlock(std::int64_t base, int n_digits, PasswordRule rule);
+
+/** Lazily walks the numbers of a range whose digits do not decrease, in ascending order.
+ * Steps between candidates work on the digits directly, without any division.
+ */
+class NonDecreasingPasswords {
+private:
+    PasswordRange m_range;
+    std::array<int, max_password_digits> m_digits;
+    std::int64_t m_value;
+public:
+    explicit NonDecreasingPasswords(PasswordRange r);
+
+    /** Advances to the next candidate. Returns false once the range is exhausted.
+     */
+    bool next();
+
+    std::int64_t value() const;
+
+    std::span<int const> digits() const;
+};
+
 #endif
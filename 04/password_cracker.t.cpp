@@ -2,6 +2,11 @@
 
 #include <catch.hpp>
 
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
 TEST_CASE("Password Cracker")
 {
     SECTION("Parse Input")
@@ -76,4 +81,163 @@ TEST_CASE("Password Cracker")
         CHECK(generateValidPasswords2(InputRange{ 111234, 111334 }) ==
             std::vector<int>{ 111244, 111255, 111266, 111277, 111288, 111299, 111334 });
     }
+
+    SECTION("Next Non-Decreasing")
+    {
+        CHECK(nextNonDecreasing(0) == 0);
+        CHECK(nextNonDecreasing(123456) == 123456);
+        CHECK(nextNonDecreasing(123450) == 123455);
+        CHECK(nextNonDecreasing(130000) == 133333);
+        CHECK(nextNonDecreasing(900000) == 999999);
+        CHECK(nextNonDecreasing(999999) == 999999);
+    }
+
+    SECTION("Count Valid Passwords")
+    {
+        CHECK(countValidPasswords(InputRange{ 123456, 123500 }) == 4);
+        CHECK(countValidPasswords2(InputRange{ 111234, 111334 }) == 7);
+        CHECK(countValidPasswords(InputRange{ 5, 4 }) == 0);
+        CHECK(countValidPasswords(InputRange{ 111111, 111111 }) == 1);
+        CHECK(countValidPasswords2(InputRange{ 111111, 111111 }) == 0);
+
+        auto const brute_force = [](InputRange r, auto is_valid) {
+            std::int64_t ret = 0;
+            for (int i = r.lower; i <= r.upper; ++i) { if (is_valid(i)) { ++ret; } }
+            return ret;
+        };
+        for (InputRange r : { InputRange{ 0, 999999 }, InputRange{ 0, 0 }, InputRange{ 1, 99 },
+                              InputRange{ 134564, 585159 }, InputRange{ 356261, 846303 }, InputRange{ 112233, 112233 } })
+        {
+            CHECK(countValidPasswords(r) == brute_force(r, isValidPassword));
+            CHECK(countValidPasswords2(r) == brute_force(r, isValidPassword2));
+            CHECK(countValidPasswords(r) == static_cast<std::int64_t>(generateValidPasswords(r).size()));
+            CHECK(countValidPasswords2(r) == static_cast<std::int64_t>(generateValidPasswords2(r).size()));
+        }
+    }
+
+    SECTION("Parse Password Range")
+    {
+        auto const r = parsePasswordRange("123456789012-987654321098\n");
+        CHECK(r.lower == 123456789012);
+        CHECK(r.upper == 987654321098);
+        CHECK(r.n_digits == 12);
+
+        CHECK_THROWS_AS(parsePasswordRange("1-1234567890123456789"), std::invalid_argument);
+        CHECK_THROWS_AS(parsePasswordRange("500-400"), std::invalid_argument);
+        CHECK_THROWS_AS(parsePasswordRange("123456"), std::invalid_argument);
+        CHECK_THROWS_AS(parsePasswordRange("1000-999"), std::invalid_argument);
+    }
+
+    SECTION("Long Digits")
+    {
+        std::array<int, 12> digits;
+        getDigits(123456789012, digits);
+        CHECK(digits == std::array<int, 12>{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2 });
+        getDigits(42, digits);
+        CHECK(digits == std::array<int, 12>{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 2 });
+        CHECK(nextNonDecreasing(123456789012, 12) == 123456789999);
+        CHECK(nextNonDecreasing(42, 12) == 44);
+        CHECK(nextNonDecreasing(420000000000, 12) == 444444444444);
+        CHECK(nextNonDecreasing(999999999999999999, 18) == 999999999999999999);
+        CHECK_THROWS_AS(nextNonDecreasing(1, 19), std::invalid_argument);
+        CHECK_THROWS_AS(nextNonDecreasing(1000, 3), std::invalid_argument);
+        CHECK_THROWS_AS(NonDecreasingPasswords(PasswordRange{ 0, 1, 0 }), std::invalid_argument);
+        CHECK_THROWS_AS(countValidPasswords(PasswordRange{ 0, 1000, 3 }, PasswordRule::AdjacentPair), std::invalid_argument);
+        CHECK_THROWS_AS(countValidPasswordsParallel(PasswordRange{ -1, 10, 2 }, PasswordRule::AdjacentPair, 1),
+                        std::invalid_argument);
+    }
+
+    SECTION("Non-Decreasing Candidates")
+    {
+        auto const collect = [](PasswordRange r) {
+            std::vector<std::int64_t> ret;
+            NonDecreasingPasswords candidates(r);
+            while (candidates.next()) {
+                REQUIRE(isIncreasing(candidates.digits()));
+                ret.push_back(candidates.value());
+            }
+            return ret;
+        };
+        CHECK(collect(PasswordRange{ 123456, 123500, 6 }) ==
+              std::vector<std::int64_t>{ 123456, 123457, 123458, 123459, 123466, 123467, 123468, 123469,
+                                         123477, 123478, 123479, 123488, 123489, 123499 });
+        CHECK(collect(PasswordRange{ 999999, 999999, 6 }) == std::vector<std::int64_t>{ 999999 });
+        CHECK(collect(PasswordRange{ 5, 4, 6 }).empty());
+        CHECK(collect(PasswordRange{ 0, 99, 2 }).size() == 55);
+
+        std::int64_t count = 0;
+        std::int64_t count2 = 0;
+        PasswordRange const r{ 123456789012, 124000000000, 12 };
+        NonDecreasingPasswords candidates(r);
+        while (candidates.next()) {
+            if (satisfiesRule(candidates.digits(), PasswordRule::AdjacentPair)) { ++count; }
+            if (satisfiesRule(candidates.digits(), PasswordRule::ExactDouble)) { ++count2; }
+        }
+        CHECK(count > 0);
+        CHECK(countValidPasswords(r, PasswordRule::AdjacentPair) == count);
+        CHECK(countValidPasswords(r, PasswordRule::ExactDouble) == count2);
+    }
+
+    SECTION("Count Long Passwords")
+    {
+        // all non-decreasing sequences of n digits: (n + 9) choose 9
+        PasswordRange const all18{ 0, 999999999999999999, 18 };
+        std::int64_t const n_increasing = 4686825;
+        // minus those with all digits distinct: 10 choose 18 is zero
+        CHECK(countValidPasswords(all18, PasswordRule::AdjacentPair) == n_increasing);
+        CHECK(countValidPasswords(PasswordRange{ 0, 999999999, 9 }, PasswordRule::AdjacentPair) == 48620 - 10);
+        CHECK(countValidPasswords(PasswordRange{ 0, 999999, 6 }, PasswordRule::ExactDouble) ==
+              countValidPasswords2(InputRange{ 0, 999999 }));
+        CHECK(countValidPasswords(PasswordRange{ 500000000000, 400000000000, 12 }, PasswordRule::AdjacentPair) == 0);
+    }
+
+    SECTION("Validate Password Block")
+    {
+        CHECK(validatePasswordBlock(123456, 6, PasswordRule::AdjacentPair) == 0);
+        CHECK(validatePasswordBlock(123496, 6, PasswordRule::AdjacentPair) == 0b1000);
+        CHECK(validatePasswordBlock(111110, 6, PasswordRule::AdjacentPair) == 0b11111110);
+        CHECK(validatePasswordBlock(111110, 6, PasswordRule::ExactDouble) == 0);
+        CHECK(validatePasswordBlock(112230, 6, PasswordRule::ExactDouble) == 0b11111000);
+        CHECK(validatePasswordBlock(111111111111111110, 18, PasswordRule::AdjacentPair) == 0b11111110);
+        CHECK(validatePasswordBlock(123456789123456780, 18, PasswordRule::AdjacentPair) == 0);
+        CHECK(validatePasswordBlock(123456788999999992, 18, PasswordRule::ExactDouble) == 0b10000000);
+        CHECK(validatePasswordBlock(123456789999999992, 18, PasswordRule::ExactDouble) == 0);
+        CHECK(validatePasswordBlock(123456789999999992, 18, PasswordRule::AdjacentPair) == 0b10000000);
+
+        // ranges shorter than the 9 digit low part
+        CHECK(validatePasswordBlock(11, 2, PasswordRule::AdjacentPair) == 0b1);
+        CHECK(validatePasswordBlock(111, 3, PasswordRule::AdjacentPair) == 0b11111111);
+        CHECK(validatePasswordBlock(111, 3, PasswordRule::ExactDouble) == 0b11111110);
+        CHECK(validatePasswordBlock(2, 1, PasswordRule::AdjacentPair) == 0);
+        CHECK_THROWS_AS(validatePasswordBlock(999996, 6, PasswordRule::AdjacentPair), std::out_of_range);
+        CHECK_THROWS_AS(validatePasswordBlock(93, 2, PasswordRule::AdjacentPair), std::out_of_range);
+        CHECK_THROWS_AS(validatePasswordBlock(3, 1, PasswordRule::AdjacentPair), std::out_of_range);
+        CHECK_THROWS_AS(validatePasswordBlock(999999996, 18, PasswordRule::AdjacentPair), std::out_of_range);
+        CHECK_THROWS_AS(validatePasswordBlock(0, 0, PasswordRule::AdjacentPair), std::invalid_argument);
+        CHECK_THROWS_AS(validatePasswordBlock(0, max_password_digits + 1, PasswordRule::AdjacentPair), std::invalid_argument);
+    }
+
+    SECTION("Parallel Validation")
+    {
+        for (auto const rule : { PasswordRule::AdjacentPair, PasswordRule::ExactDouble }) {
+            for (PasswordRange const r : { PasswordRange{ 0, 999999, 6 }, PasswordRange{ 134564, 585159, 6 },
+                                           PasswordRange{ 5, 4, 6 }, PasswordRange{ 111111, 111111, 6 },
+                                           PasswordRange{ 0, 99, 2 }, PasswordRange{ 0, 7, 1 },
+                                           PasswordRange{ 0, 9, 1 }, PasswordRange{ 87, 99, 2 },
+                                           PasswordRange{ 122999999990, 123000400000, 12 },
+                                           PasswordRange{ 111111111111111100, 111111111111222222, 18 } })
+            {
+                std::vector<std::int64_t> expected;
+                NonDecreasingPasswords candidates(r);
+                while (candidates.next()) {
+                    if (satisfiesRule(candidates.digits(), rule)) { expected.push_back(candidates.value()); }
+                }
+                CHECK(countValidPasswords(r, rule) == static_cast<std::int64_t>(expected.size()));
+                for (unsigned n_threads : { 1, 3 }) {
+                    CHECK(countValidPasswordsParallel(r, rule, n_threads) == static_cast<std::int64_t>(expected.size()));
+                    CHECK(findValidPasswordsParallel(r, rule, n_threads) == expected);
+                }
+            }
+        }
+    }
 }
@@ -1,10 +1,13 @@
 #include <planet_orbits.hpp>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 std::optional<std::string> readInput(char const* filename)
 {
@@ -23,10 +26,36 @@ std::optional<std::string> readInput(char const* filename)
     return sstr.str();
 }
 
+/** Times building and counting a degenerate chain of one million planets, the worst case for deep traversals.
+ */
+void benchmarkDeepChain()
+{
+    using Clock = std::chrono::steady_clock;
+    int const chain_length = 1'000'000;
+    std::vector<Orbit> orbits;
+    orbits.reserve(chain_length - 1);
+    for (int i = chain_length - 1; i > 0; --i) {
+        orbits.push_back(Orbit{ std::string("P").append(std::to_string(i - 1)), std::string("P").append(std::to_string(i)) });
+    }
+    auto const measure = [](char const* label, auto const& run) {
+        auto const t0 = Clock::now();
+        std::int64_t const result = run();
+        std::chrono::duration<double, std::milli> const elapsed = Clock::now() - t0;
+        std::cout << "  " << label << ": " << result << " orbits in " << elapsed.count() << "ms" << std::endl;
+    };
+    std::cout << "Chain of " << chain_length << " planets:" << std::endl;
+    measure("PlanetTree", [&orbits]() { return countAllOrbits(buildPlanetTree(orbits)); });
+    measure("CompactPlanetTree", [&orbits]() { return countAllOrbits(buildCompactPlanetTree(orbits)); });
+}
+
 int main(int argc, char* argv[])
 {
     char const* input_filename = "input";
-    if(argc == 2) {
+    bool run_benchmark = false;
+    if((argc == 3) && (std::string_view(argv[2]) == "--benchmark")) {
+        run_benchmark = true;
+    }
+    if((argc == 2) || run_benchmark) {
         input_filename = argv[1];
     }
 
@@ -43,5 +72,9 @@ int main(int argc, char* argv[])
 
     std::cout << "Second result is " << commonElement(galaxy, "YOU", "SAN") << std::endl;
 
+    if(run_benchmark) {
+        benchmarkDeepChain();
+    }
+
     return 0;
 }
@@ -5,10 +5,13 @@
 #include <range/v3/range/conversion.hpp>
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstring>
 #include <limits>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
 
@@ -45,17 +48,23 @@ PlanetTree buildPlanetTree(std::vector<Orbit> const& input)
     Node* root_candidate = &ret.nodes.front();
     while (root_candidate->parent) { root_candidate = root_candidate->parent; }
     ret.root = root_candidate;
+    // depths
+    std::vector<Node*> stack{ ret.root };
+    while (!stack.empty()) {
+        Node* n = stack.back();
+        stack.pop_back();
+        for (Node* o : n->orbiters) {
+            o->depth = n->depth + 1;
+            stack.push_back(o);
+        }
+    }
     return ret;
 }
 
-int countAllOrbits(PlanetTree const& t)
+std::int64_t countAllOrbits(PlanetTree const& t)
 {
-    int acc = 0;
-    for (auto const& node : t.nodes) {
-        Node const* it = &node;
-        while (it->parent) { it = it->parent; ++acc; }
-    }
-    return acc;
+    return std::accumulate(begin(t.nodes), end(t.nodes), std::int64_t{ 0 },
+                           [](std::int64_t acc, Node const& n) { return acc + n.depth; });
 }
 
 Node const* findPlanet(PlanetTree const& t, Planet const& p)
@@ -81,3 +90,374 @@ int commonElement(PlanetTree const& t, Planet const& p1, Planet const& p2)
     auto const d2 = std::distance(begin(path2), it_start2.base());
     return static_cast<int>(d1 + d2);
 }
+
+PlanetIndex buildPlanetIndex(PlanetTree const& t)
+{
+    PlanetIndex ret;
+    ret.reserve(t.nodes.size());
+    for (auto const& n : t.nodes) { ret.emplace(n.planet, &n); }
+    return ret;
+}
+
+Node const* findPlanet(PlanetIndex const& index, std::string_view p)
+{
+    auto const it = index.find(p);
+    return (it != end(index)) ? it->second : nullptr;
+}
+
+namespace {
+/** Calls f for n and every node orbiting it, parents before orbiters.
+ */
+template<typename Func_T>
+void forEachInSubtree(Node* n, Func_T&& f)
+{
+    std::vector<Node*> stack{ n };
+    while (!stack.empty()) {
+        Node* it = stack.back();
+        stack.pop_back();
+        f(it);
+        stack.insert(stack.end(), it->orbiters.begin(), it->orbiters.end());
+    }
+}
+
+void detachFromParent(Node* n)
+{
+    assert(n->parent);
+    auto& siblings = n->parent->orbiters;
+    siblings.erase(std::find(begin(siblings), end(siblings), n));
+    n->parent = nullptr;
+}
+}
+
+OrbitMap::OrbitMap(std::vector<Orbit> const& input)
+    :m_tree(buildPlanetTree(input)), m_totalOrbits(0)
+{
+    m_index.reserve(m_tree.nodes.size());
+    for (auto it = begin(m_tree.nodes); it != end(m_tree.nodes); ++it) {
+        m_index.emplace(it->planet, it);
+        m_totalOrbits += it->depth;
+    }
+}
+
+PlanetTree const& OrbitMap::tree() const
+{
+    return m_tree;
+}
+
+Node const* OrbitMap::find(std::string_view p) const
+{
+    auto const it = m_index.find(p);
+    return (it != end(m_index)) ? &(*it->second) : nullptr;
+}
+
+std::int64_t OrbitMap::totalOrbits() const
+{
+    return m_totalOrbits;
+}
+
+bool OrbitMap::addOrbit(Orbit const& o)
+{
+    auto const it_center = m_index.find(o.center);
+    auto const it_orbiter = m_index.find(o.orbiter);
+    if ((it_center != end(m_index)) && (it_orbiter == end(m_index))) {
+        // new leaf
+        Node* center = &(*it_center->second);
+        m_tree.nodes.push_back(Node{ o.orbiter, center, {}, center->depth + 1 });
+        auto const it_node = std::prev(end(m_tree.nodes));
+        center->orbiters.push_back(&(*it_node));
+        m_index.emplace(it_node->planet, it_node);
+        m_totalOrbits += it_node->depth;
+        return true;
+    } else if ((it_center == end(m_index)) && (it_orbiter != end(m_index)) && (&(*it_orbiter->second) == m_tree.root)) {
+        // new root; every existing planet moves one orbit further out
+        m_tree.nodes.push_back(Node{ o.center, nullptr, { m_tree.root }, 0 });
+        auto const it_node = std::prev(end(m_tree.nodes));
+        m_tree.root->parent = &(*it_node);
+        forEachInSubtree(m_tree.root, [](Node* n) { ++n->depth; });
+        m_totalOrbits += static_cast<std::int64_t>(m_tree.nodes.size()) - 1;
+        m_tree.root = &(*it_node);
+        m_index.emplace(it_node->planet, it_node);
+        return true;
+    }
+    return false;
+}
+
+bool OrbitMap::removePlanet(std::string_view p)
+{
+    auto const it = m_index.find(p);
+    if ((it == end(m_index)) || (&(*it->second) == m_tree.root)) { return false; }
+    Node* n = &(*it->second);
+    detachFromParent(n);
+    std::vector<std::list<Node>::iterator> removed;
+    forEachInSubtree(n, [this, &removed](Node* r) {
+            m_totalOrbits -= r->depth;
+            auto const it_index = m_index.find(r->planet);
+            removed.push_back(it_index->second);
+            m_index.erase(it_index);
+        });
+    for (auto const& it_node : removed) { m_tree.nodes.erase(it_node); }
+    return true;
+}
+
+bool OrbitMap::reparent(std::string_view p, std::string_view new_center)
+{
+    auto const it = m_index.find(p);
+    auto const it_center = m_index.find(new_center);
+    if ((it == end(m_index)) || (it_center == end(m_index))) { return false; }
+    Node* n = &(*it->second);
+    Node* center = &(*it_center->second);
+    bool creates_cycle = false;
+    std::int64_t subtree_size = 0;
+    forEachInSubtree(n, [center, &creates_cycle, &subtree_size](Node* s) {
+            creates_cycle = creates_cycle || (s == center);
+            ++subtree_size;
+        });
+    if (creates_cycle) { return false; }
+    detachFromParent(n);
+    n->parent = center;
+    center->orbiters.push_back(n);
+    int const delta = center->depth + 1 - n->depth;
+    forEachInSubtree(n, [delta](Node* s) { s->depth += delta; });
+    m_totalOrbits += delta * subtree_size;
+    return true;
+}
+
+namespace {
+std::optional<std::uint64_t> packName(std::string_view name)
+{
+    std::uint64_t ret = 0;
+    if (name.size() > sizeof(ret)) { return std::nullopt; }
+    std::memcpy(&ret, name.data(), name.size());
+    return ret;
+}
+
+template<typename Func_T>
+CompactPlanetTree buildCompactPlanetTree_impl(Func_T&& for_each_orbit)
+{
+    CompactPlanetTree ret;
+    std::vector<std::uint32_t> n_orbiters;
+    auto const get_or_insert = [&ret, &n_orbiters](std::string_view name) {
+        PlanetId const id = ret.names.intern(name);
+        if (id == ret.parent.size()) {
+            ret.parent.push_back(invalid_planet);
+            n_orbiters.push_back(0);
+        }
+        return id;
+    };
+    for_each_orbit([&](std::string_view center, std::string_view orbiter) {
+            PlanetId const orbiter_id = get_or_insert(orbiter);
+            PlanetId const center_id = get_or_insert(center);
+            assert(ret.parent[orbiter_id] == invalid_planet);
+            ret.parent[orbiter_id] = center_id;
+            ++n_orbiters[center_id];
+        });
+
+    // orbiters in CSR layout, each planet's orbiters in input order
+    ret.orbiterOffsets.resize(n_orbiters.size() + 1);
+    ret.orbiterOffsets[0] = 0;
+    std::partial_sum(begin(n_orbiters), end(n_orbiters), begin(ret.orbiterOffsets) + 1);
+    ret.orbiters.resize(ret.orbiterOffsets.back());
+    std::vector<std::uint32_t> fill(begin(ret.orbiterOffsets), end(ret.orbiterOffsets) - 1);
+    for (PlanetId i = 0; i < ret.parent.size(); ++i) {
+        if (ret.parent[i] != invalid_planet) { ret.orbiters[fill[ret.parent[i]]++] = i; }
+    }
+
+    ret.root = invalid_planet;
+    if (!ret.parent.empty()) {
+        ret.root = 0;
+        while (ret.parent[ret.root] != invalid_planet) { ret.root = ret.parent[ret.root]; }
+    }
+    ret.depth = computeDepths(ret);
+    return ret;
+}
+}
+
+PlanetId PlanetNames::intern(std::string_view name)
+{
+    PlanetId const new_id = static_cast<PlanetId>(size());
+    bool inserted;
+    PlanetId id;
+    if (auto const packed = packName(name); packed) {
+        auto const [it, ins] = m_packedIds.emplace(*packed, new_id);
+        id = it->second;
+        inserted = ins;
+    } else {
+        auto const [it, ins] = m_longIds.emplace(std::string(name), new_id);
+        id = it->second;
+        inserted = ins;
+    }
+    if (inserted) {
+        assert(new_id != invalid_planet);
+        m_storage.append(name);
+        m_offsets.push_back(static_cast<std::uint32_t>(m_storage.size()));
+    }
+    return id;
+}
+
+std::optional<PlanetId> PlanetNames::find(std::string_view name) const
+{
+    if (auto const packed = packName(name); packed) {
+        auto const it = m_packedIds.find(*packed);
+        if (it != end(m_packedIds)) { return it->second; }
+    } else {
+        auto const it = m_longIds.find(std::string(name));
+        if (it != end(m_longIds)) { return it->second; }
+    }
+    return std::nullopt;
+}
+
+std::string_view PlanetNames::name(PlanetId id) const
+{
+    assert(id < size());
+    return std::string_view(m_storage).substr(m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+}
+
+std::size_t PlanetNames::size() const
+{
+    return m_offsets.size() - 1;
+}
+
+CompactPlanetTree buildCompactPlanetTree(std::string_view input)
+{
+    return buildCompactPlanetTree_impl([input](auto&& on_orbit) {
+            std::size_t line_start = 0;
+            while (line_start < input.size()) {
+                std::size_t line_end = input.find('\n', line_start);
+                if (line_end == std::string_view::npos) { line_end = input.size(); }
+                std::string_view const line = input.substr(line_start, line_end - line_start);
+                line_start = line_end + 1;
+                if (line.empty()) { continue; }
+                std::size_t const separator = line.find(')');
+                assert(separator != std::string_view::npos);
+                on_orbit(line.substr(0, separator), line.substr(separator + 1));
+            }
+        });
+}
+
+CompactPlanetTree buildCompactPlanetTree(std::vector<Orbit> const& input)
+{
+    return buildCompactPlanetTree_impl([&input](auto&& on_orbit) {
+            for (auto const& o : input) { on_orbit(o.center, o.orbiter); }
+        });
+}
+
+CompactPlanetTree buildCompactPlanetTree(PlanetTree const& t)
+{
+    return buildCompactPlanetTree_impl([&t](auto&& on_orbit) {
+            for (auto const& n : t.nodes) {
+                if (n.parent) { on_orbit(n.parent->planet, n.planet); }
+            }
+        });
+}
+
+std::span<PlanetId const> getOrbiters(CompactPlanetTree const& t, PlanetId p)
+{
+    assert(p < t.parent.size());
+    return std::span<PlanetId const>(t.orbiters).subspan(t.orbiterOffsets[p], t.orbiterOffsets[p + 1] - t.orbiterOffsets[p]);
+}
+
+std::vector<std::uint32_t> computeDepths(CompactPlanetTree const& t)
+{
+    std::vector<std::uint32_t> ret(t.parent.size(), 0);
+    if (t.root == invalid_planet) { return ret; }
+    // the queue is filled in breadth-first order, so every parent is visited before its orbiters
+    std::vector<PlanetId> queue;
+    queue.reserve(t.parent.size());
+    queue.push_back(t.root);
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        PlanetId const p = queue[i];
+        for (PlanetId o : getOrbiters(t, p)) {
+            ret[o] = ret[p] + 1;
+            queue.push_back(o);
+        }
+    }
+    assert(queue.size() == t.parent.size());
+    return ret;
+}
+
+std::int64_t countAllOrbits(CompactPlanetTree const& t)
+{
+    return std::accumulate(begin(t.depth), end(t.depth), std::int64_t{ 0 });
+}
+
+OrbitalTransferIndex::OrbitalTransferIndex(CompactPlanetTree const& t)
+    :m_tree(&t), m_preorder(t.parent.size())
+{
+    std::size_t const n = t.parent.size();
+    if (n == 0) { return; }
+    std::vector<PlanetId> order;
+    order.reserve(n);
+    std::vector<PlanetId> stack{ t.root };
+    while (!stack.empty()) {
+        PlanetId const p = stack.back();
+        stack.pop_back();
+        m_preorder[p] = static_cast<std::uint32_t>(order.size());
+        order.push_back(p);
+        auto const orbiters = getOrbiters(t, p);
+        stack.insert(stack.end(), orbiters.rbegin(), orbiters.rend());
+    }
+    assert(order.size() == n);
+
+    m_shallowest.push_back(std::move(order));
+    for (std::size_t width = 2; width <= n; width *= 2) {
+        auto const& prev = m_shallowest.back();
+        std::vector<PlanetId> level(n - width + 1);
+        for (std::size_t i = 0; i < level.size(); ++i) {
+            PlanetId const a = prev[i];
+            PlanetId const b = prev[i + width / 2];
+            level[i] = (t.depth[a] <= t.depth[b]) ? a : b;
+        }
+        m_shallowest.push_back(std::move(level));
+    }
+}
+
+PlanetId OrbitalTransferIndex::lowestCommonAncestor(PlanetId p1, PlanetId p2) const
+{
+    assert((p1 < m_preorder.size()) && (p2 < m_preorder.size()));
+    if (p1 == p2) { return p1; }
+    auto const [first, last] = std::minmax(m_preorder[p1], m_preorder[p2]);
+    std::uint32_t const begin = first + 1;
+    std::uint32_t const width = last - begin + 1;
+    int const k = std::bit_width(width) - 1;
+    PlanetId const a = m_shallowest[k][begin];
+    PlanetId const b = m_shallowest[k][last + 1 - (1u << k)];
+    return m_tree->parent[(m_tree->depth[a] <= m_tree->depth[b]) ? a : b];
+}
+
+std::uint32_t OrbitalTransferIndex::distance(PlanetId p1, PlanetId p2) const
+{
+    auto const& depth = m_tree->depth;
+    return depth[p1] + depth[p2] - 2 * depth[lowestCommonAncestor(p1, p2)];
+}
+
+std::uint32_t OrbitalTransferIndex::transferDistance(PlanetId p1, PlanetId p2) const
+{
+    assert((m_tree->parent[p1] != invalid_planet) && (m_tree->parent[p2] != invalid_planet));
+    return distance(m_tree->parent[p1], m_tree->parent[p2]);
+}
+
+std::optional<std::uint32_t> OrbitalTransferIndex::transferDistance(std::string_view p1, std::string_view p2) const
+{
+    auto const id1 = m_tree->names.find(p1);
+    auto const id2 = m_tree->names.find(p2);
+    if (!id1 || !id2 || (*id1 == m_tree->root) || (*id2 == m_tree->root)) { return std::nullopt; }
+    return transferDistance(*id1, *id2);
+}
+
+std::vector<std::uint32_t> transferDistances(OrbitalTransferIndex const& index, std::span<TransferQuery const> queries,
+                                             unsigned n_threads)
+{
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    std::vector<std::uint32_t> ret(queries.size());
+    auto const answer = [&index, &queries, &ret](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) { ret[i] = index.transferDistance(queries[i].from, queries[i].to); }
+    };
+    std::size_t const slice = (queries.size() + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (std::size_t first = slice; first < queries.size(); first += slice) {
+        threads.emplace_back(answer, first, std::min(first + slice, queries.size()));
+    }
+    answer(0, std::min(slice, queries.size()));
+    for (auto& t : threads) { t.join(); }
+    return ret;
+}
@@ -1,7 +1,11 @@
 #ifndef ADVENT_OF_CODE_06_PLANET_ORBITS_HPP_INCLUDE_GUARD
 #define ADVENT_OF_CODE_06_PLANET_ORBITS_HPP_INCLUDE_GUARD
 
+#include <cstdint>
+#include <limits>
 #include <list>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <string>
 #include <unordered_map>
@@ -18,6 +22,7 @@ struct Node {
     Planet planet;
     Node* parent;
     std::vector<Node*> orbiters;
+    int depth = 0;                  ///< number of orbits from this node to the root
 };
 
 struct PlanetTree {
@@ -29,7 +34,9 @@ std::vector<Orbit> parseInput(std::string_view input);
 
 PlanetTree buildPlanetTree(std::vector<Orbit> const& input);
 
-int countAllOrbits(PlanetTree const& t);
+/** Total number of direct and indirect orbits, i.e. the sum of all planet depths. Runs in O(n).
+ */
+std::int64_t countAllOrbits(PlanetTree const& t);
 
 Node const* findPlanet(PlanetTree const& t, Planet const& p);
 
@@ -37,4 +44,135 @@ std::vector<Node const*> pathToRoot(PlanetTree const& t, Planet const& p);
 
 int commonElement(PlanetTree const& t, Planet const& p1, Planet const& p2);
 
+/** Hash index from planet name to node, for lookups without scanning PlanetTree::nodes.
+ * The keys point into the tree's nodes and are valid as long as the tree is.
+ */
+using PlanetIndex = std::unordered_map<std::string_view, Node const*>;
+
+PlanetIndex buildPlanetIndex(PlanetTree const& t);
+
+/** Returns nullptr if p is not in the index.
+ */
+Node const* findPlanet(PlanetIndex const& index, std::string_view p);
+
+/** PlanetTree that can be modified in place.
+ * Depths and the total orbit count are kept up to date on every change, and the name lookup stays valid.
+ * Each operation costs time proportional to the subtree it moves, adds or removes.
+ */
+class OrbitMap {
+private:
+    PlanetTree m_tree;
+    std::unordered_map<std::string_view, std::list<Node>::iterator> m_index;
+    std::int64_t m_totalOrbits;
+public:
+    explicit OrbitMap(std::vector<Orbit> const& input);
+
+    /** The index refers into the nodes of m_tree, so copies would point back into the source.
+     * Moving keeps the nodes in place and the index valid.
+     */
+    OrbitMap(OrbitMap const&) = delete;
+    OrbitMap& operator=(OrbitMap const&) = delete;
+    OrbitMap(OrbitMap&&) = default;
+    OrbitMap& operator=(OrbitMap&&) = default;
+
+    PlanetTree const& tree() const;
+    Node const* find(std::string_view p) const;
+    std::int64_t totalOrbits() const;
+
+    /** Adds orbiter around center. Either orbiter is a new planet and center already exists,
+     * or orbiter is the current root and center is a new planet that becomes the root.
+     * Returns false if neither is the case.
+     */
+    bool addOrbit(Orbit const& o);
+    /** Removes p and every planet orbiting it directly or indirectly. The root cannot be removed.
+     */
+    bool removePlanet(std::string_view p);
+    /** Moves p, together with everything orbiting it, to orbit new_center instead.
+     * Returns false if that would create a cycle.
+     */
+    bool reparent(std::string_view p, std::string_view new_center);
+};
+
+using PlanetId = std::uint32_t;
+
+PlanetId constexpr invalid_planet = std::numeric_limits<PlanetId>::max();
+
+/** Interns planet names to dense ids, assigned in order of first appearance.
+ * Names of up to 8 characters are looked up by their characters packed into an integer;
+ * only longer names go through string hashing.
+ */
+class PlanetNames {
+private:
+    std::unordered_map<std::uint64_t, PlanetId> m_packedIds;
+    std::unordered_map<std::string, PlanetId> m_longIds;
+    std::string m_storage;                     ///< all names, concatenated
+    std::vector<std::uint32_t> m_offsets{ 0 }; ///< name i is [m_offsets[i], m_offsets[i+1]) in m_storage
+public:
+    PlanetId intern(std::string_view name);
+    std::optional<PlanetId> find(std::string_view name) const;
+    std::string_view name(PlanetId id) const;
+    std::size_t size() const;
+};
+
+/** Planet tree in flat arrays indexed by PlanetId.
+ */
+struct CompactPlanetTree {
+    PlanetNames names;
+    std::vector<PlanetId> parent;              ///< invalid_planet for the root
+    std::vector<std::uint32_t> orbiterOffsets; ///< orbiters of i are [orbiterOffsets[i], orbiterOffsets[i+1]) in orbiters
+    std::vector<PlanetId> orbiters;
+    std::vector<std::uint32_t> depth;          ///< number of orbits from planet i to the root
+    PlanetId root;
+};
+
+/** Builds the compact tree in a single pass over the raw orbit map, without materializing Orbits.
+ */
+CompactPlanetTree buildCompactPlanetTree(std::string_view input);
+
+CompactPlanetTree buildCompactPlanetTree(std::vector<Orbit> const& input);
+
+CompactPlanetTree buildCompactPlanetTree(PlanetTree const& t);
+
+std::span<PlanetId const> getOrbiters(CompactPlanetTree const& t, PlanetId p);
+
+/** Depth of every planet, computed in O(n) by an iterative breadth-first walk from the root.
+ */
+std::vector<std::uint32_t> computeDepths(CompactPlanetTree const& t);
+
+std::int64_t countAllOrbits(CompactPlanetTree const& t);
+
+/** Lowest common ancestor index for answering transfer queries on a fixed tree.
+ * Planets are laid out in depth-first preorder. The lowest common ancestor of two distinct planets u and v is
+ * the parent of the shallowest planet in the preorder range (pre(u), pre(v)], which is found with
+ * a sparse table range minimum query in O(1). Building takes O(n log n) time and memory.
+ * The index refers to the tree it was built from, which must outlive it and not be modified.
+ */
+class OrbitalTransferIndex {
+private:
+    CompactPlanetTree const* m_tree;
+    std::vector<std::uint32_t> m_preorder;                  ///< preorder position of planet i
+    std::vector<std::vector<PlanetId>> m_shallowest;        ///< [k][i] is the shallowest planet in preorder [i, i + 2^k)
+public:
+    explicit OrbitalTransferIndex(CompactPlanetTree const& t);
+    PlanetId lowestCommonAncestor(PlanetId p1, PlanetId p2) const;
+    /** Number of orbits between p1 and p2.
+     */
+    std::uint32_t distance(PlanetId p1, PlanetId p2) const;
+    /** Orbital transfers needed to move from the body p1 orbits to the body p2 orbits; neither may be the root.
+     */
+    std::uint32_t transferDistance(PlanetId p1, PlanetId p2) const;
+    std::optional<std::uint32_t> transferDistance(std::string_view p1, std::string_view p2) const;
+};
+
+struct TransferQuery {
+    PlanetId from;
+    PlanetId to;
+};
+
+/** Answers all queries with OrbitalTransferIndex::transferDistance(), split evenly across n_threads threads.
+ * Passing 0 for n_threads uses the hardware concurrency.
+ */
+std::vector<std::uint32_t> transferDistances(OrbitalTransferIndex const& index, std::span<TransferQuery const> queries,
+                                             unsigned n_threads = 0);
+
 #endif
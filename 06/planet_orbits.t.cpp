@@ -2,6 +2,10 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
 TEST_CASE("Planet Orbits")
 {
     char const galaxy[] = "COM)B\nB)C\nC)D\nD)E\nE)F\nB)G\nG)H\nD)I\nE)J\nJ)K\nK)L";
@@ -48,4 +52,196 @@ TEST_CASE("Planet Orbits")
         auto t = buildPlanetTree(orbits);
         CHECK(commonElement(t, "YOU", "SAN") == 4);
     }
+
+    SECTION("Planet Names")
+    {
+        PlanetNames names;
+        CHECK(names.intern("COM") == 0);
+        CHECK(names.intern("B") == 1);
+        CHECK(names.intern("VERYLONGNAME") == 2);
+        CHECK(names.intern("COM") == 0);
+        CHECK(names.intern("VERYLONGNAME") == 2);
+        CHECK(names.intern("CO") == 3);
+        CHECK(names.size() == 4);
+        CHECK(names.name(0) == "COM");
+        CHECK(names.name(2) == "VERYLONGNAME");
+        CHECK(names.name(3) == "CO");
+        CHECK(names.find("B") == 1);
+        CHECK(names.find("VERYLONGNAME") == 2);
+        CHECK(!names.find("C"));
+        CHECK(!names.find("VERYLONGNAMES"));
+    }
+
+    SECTION("Build Compact Tree")
+    {
+        auto const check_tree = [](CompactPlanetTree const& t) {
+            REQUIRE(t.names.size() == 12);
+            REQUIRE(t.parent.size() == 12);
+            CHECK(t.names.name(t.root) == "COM");
+            CHECK(t.parent[t.root] == invalid_planet);
+            auto const id = [&t](std::string_view n) { return *t.names.find(n); };
+            CHECK(t.parent[id("B")] == id("COM"));
+            CHECK(t.parent[id("L")] == id("K"));
+            CHECK(t.parent[id("I")] == id("D"));
+            auto const orbiters_of = [&t, &id](std::string_view n) {
+                std::vector<std::string_view> ret;
+                for (PlanetId o : getOrbiters(t, id(n))) { ret.push_back(t.names.name(o)); }
+                return ret;
+            };
+            CHECK(orbiters_of("B") == std::vector<std::string_view>{ "C", "G" });
+            CHECK(orbiters_of("E") == std::vector<std::string_view>{ "F", "J" });
+            CHECK(orbiters_of("COM") == std::vector<std::string_view>{ "B" });
+            CHECK(orbiters_of("L").empty());
+            CHECK(t.orbiters.size() == 11);
+        };
+        check_tree(buildCompactPlanetTree(galaxy));
+        check_tree(buildCompactPlanetTree(std::string(galaxy) + "\n"));
+        check_tree(buildCompactPlanetTree(parseInput(galaxy)));
+    }
+
+    SECTION("Depths")
+    {
+        auto const t = buildCompactPlanetTree(galaxy);
+        CHECK(t.depth == computeDepths(t));
+        auto const depth_of = [&t](std::string_view n) { return t.depth[*t.names.find(n)]; };
+        CHECK(depth_of("COM") == 0);
+        CHECK(depth_of("B") == 1);
+        CHECK(depth_of("D") == 3);
+        CHECK(depth_of("L") == 7);
+        CHECK(countAllOrbits(t) == 42);
+    }
+
+    SECTION("Deep Chain")
+    {
+        // long enough that recursive traversal would be noticeable; advent06 --benchmark runs one million planets
+        int const chain_length = 5'000;
+        std::vector<Orbit> orbits;
+        orbits.reserve(chain_length - 1);
+        auto const name = [](int i) { return std::string("P").append(std::to_string(i)); };
+        for (int i = chain_length - 1; i > 0; --i) {
+            orbits.push_back(Orbit{ name(i - 1), name(i) });
+        }
+        std::int64_t const expected = std::int64_t{ chain_length } * (chain_length - 1) / 2;
+        auto const t = buildCompactPlanetTree(orbits);
+        CHECK(t.names.name(t.root) == "P0");
+        CHECK(t.depth[*t.names.find("P4999")] == chain_length - 1);
+        CHECK(countAllOrbits(t) == expected);
+        CHECK(countAllOrbits(buildPlanetTree(orbits)) == expected);
+    }
+
+    SECTION("Planet Index")
+    {
+        auto const t = buildPlanetTree(parseInput(galaxy2));
+        auto const index = buildPlanetIndex(t);
+        CHECK(index.size() == t.nodes.size());
+        CHECK(findPlanet(index, "SAN") == findPlanet(t, "SAN"));
+        CHECK(findPlanet(index, "COM") == t.root);
+        CHECK(findPlanet(index, "XYZ") == nullptr);
+    }
+
+    SECTION("Transfer Index")
+    {
+        auto const t = buildCompactPlanetTree(buildPlanetTree(parseInput(galaxy2)));
+        REQUIRE(t.names.size() == 14);
+        OrbitalTransferIndex const index(t);
+        auto const id = [&t](std::string_view n) { return *t.names.find(n); };
+        CHECK(index.lowestCommonAncestor(id("YOU"), id("SAN")) == id("D"));
+        CHECK(index.lowestCommonAncestor(id("H"), id("L")) == id("B"));
+        CHECK(index.lowestCommonAncestor(id("E"), id("L")) == id("E"));
+        CHECK(index.lowestCommonAncestor(id("L"), id("E")) == id("E"));
+        CHECK(index.lowestCommonAncestor(id("F"), id("F")) == id("F"));
+        CHECK(index.distance(id("COM"), id("YOU")) == 7);
+        CHECK(index.distance(id("H"), id("F")) == 6);
+        CHECK(index.transferDistance("YOU", "SAN") == 4);
+        CHECK(!index.transferDistance("YOU", "XYZ"));
+        CHECK(!index.transferDistance("COM", "SAN"));
+
+        // compare all pairs against climbing the parent links
+        auto const naive_distance = [&t](PlanetId a, PlanetId b) {
+            std::uint32_t ret = 0;
+            while (a != b) {
+                if (t.depth[a] >= t.depth[b]) { a = t.parent[a]; } else { b = t.parent[b]; }
+                ++ret;
+            }
+            return ret;
+        };
+        std::vector<TransferQuery> queries;
+        std::vector<std::uint32_t> expected;
+        for (PlanetId p1 = 0; p1 < t.names.size(); ++p1) {
+            for (PlanetId p2 = 0; p2 < t.names.size(); ++p2) {
+                if ((p1 == t.root) || (p2 == t.root)) { continue; }
+                queries.push_back(TransferQuery{ p1, p2 });
+                expected.push_back(naive_distance(t.parent[p1], t.parent[p2]));
+            }
+        }
+        CHECK(transferDistances(index, queries, 1) == expected);
+        CHECK(transferDistances(index, queries, 4) == expected);
+        CHECK(transferDistances(index, {}, 4).empty());
+    }
+
+    SECTION("Orbit Map Updates")
+    {
+        OrbitMap m(parseInput(galaxy));
+        auto const check_consistent = [&m]() {
+            for (auto const& n : m.tree().nodes) {
+                CHECK(m.find(n.planet) == &n);
+                int depth = 0;
+                for (Node const* it = &n; it->parent; it = it->parent) { ++depth; }
+                CHECK(n.depth == depth);
+            }
+            CHECK(m.totalOrbits() == countAllOrbits(m.tree()));
+        };
+        CHECK(m.totalOrbits() == 42);
+        CHECK(m.find("L")->depth == 7);
+        check_consistent();
+
+        // new leaves
+        CHECK(m.addOrbit(Orbit{ "K", "YOU" }));
+        CHECK(m.addOrbit(Orbit{ "I", "SAN" }));
+        CHECK(m.totalOrbits() == 42 + 7 + 5);
+        CHECK(m.find("YOU")->parent == m.find("K"));
+        check_consistent();
+        CHECK(!m.addOrbit(Orbit{ "K", "YOU" }));
+        CHECK(!m.addOrbit(Orbit{ "X", "Y" }));
+        CHECK(!m.addOrbit(Orbit{ "X", "B" }));
+
+        // new root
+        CHECK(m.addOrbit(Orbit{ "ROOT", "COM" }));
+        CHECK(m.tree().root == m.find("ROOT"));
+        CHECK(m.find("COM")->depth == 1);
+        check_consistent();
+
+        // move a subtree
+        CHECK(m.reparent("J", "B"));
+        CHECK(m.find("L")->depth == 5);
+        CHECK(m.find("J")->parent == m.find("B"));
+        CHECK(std::count(begin(m.find("E")->orbiters), end(m.find("E")->orbiters), m.find("J")) == 0);
+        check_consistent();
+        CHECK(!m.reparent("B", "L"));
+        CHECK(!m.reparent("B", "B"));
+        CHECK(!m.reparent("B", "XYZ"));
+        check_consistent();
+
+        // remove a subtree
+        CHECK(m.removePlanet("J"));
+        CHECK(m.find("J") == nullptr);
+        CHECK(m.find("YOU") == nullptr);
+        CHECK(m.tree().nodes.size() == 11);
+        check_consistent();
+        CHECK(!m.removePlanet("J"));
+        CHECK(!m.removePlanet("ROOT"));
+        CHECK(m.removePlanet("SAN"));
+        check_consistent();
+        CHECK(m.totalOrbits() == 1 + 2 + 3 + 4 + 5 + 6 + 3 + 4 + 5);
+
+        // the index points into the map's own nodes, so it can only be moved
+        static_assert(!std::is_copy_constructible_v<OrbitMap> && !std::is_copy_assignable_v<OrbitMap>);
+        auto moved_from = std::make_unique<OrbitMap>(std::move(m));
+        OrbitMap moved = std::move(*moved_from);
+        moved_from.reset();
+        CHECK(moved.find("C")->planet == "C");
+        CHECK(moved.reparent("H", "F"));
+        CHECK(moved.find("H")->depth == 7);
+        CHECK(moved.totalOrbits() == countAllOrbits(moved.tree()));
+    }
 }
@@ -1,10 +1,15 @@
 #include <amp_settings.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 std::optional<std::string> readInput(char const* filename)
 {
@@ -23,10 +28,41 @@ std::optional<std::string> readInput(char const* filename)
     return sstr.str();
 }
 
+/** Compares the sequential feedback loop against the threaded pipeline.
+ * Latency is the time for a single run, throughput is runs per second when going through all phase permutations.
+ */
+void benchmarkFeedbackModes(IntegerProgram const& p)
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<IntegerProgram> amps;
+    auto const measure = [&p](auto const& run) {
+        std::vector<int> phases(5);
+        std::iota(begin(phases), end(phases), 5);
+        int checksum = 0;
+        int n_runs = 0;
+        auto const t0 = Clock::now();
+        do {
+            checksum = std::max(checksum, run(phases));
+            ++n_runs;
+        } while (std::next_permutation(begin(phases), end(phases)));
+        std::chrono::duration<double, std::micro> const elapsed = Clock::now() - t0;
+        std::cout << "  max signal " << checksum << ", latency " << (elapsed.count() / n_runs) << "us/run, throughput "
+                  << (n_runs / elapsed.count() * 1e6) << " runs/s" << std::endl;
+    };
+    std::cout << "Sequential feedback loop:" << std::endl;
+    measure([&p, &amps](std::vector<int> const& phases) { return runAmps(p, phases, AmpMode::Feedback, amps); });
+    std::cout << "Pipelined feedback loop:" << std::endl;
+    measure([&p](std::vector<int> const& phases) { return runAmpsPipelined(p, phases, AmpMode::Feedback); });
+}
+
 int main(int argc, char* argv[])
 {
     char const* input_filename = "input";
-    if(argc == 2) {
+    bool run_benchmark = false;
+    if((argc == 3) && (std::string_view(argv[2]) == "--benchmark")) {
+        run_benchmark = true;
+    }
+    if((argc == 2) || run_benchmark) {
         input_filename = argv[1];
     }
 
@@ -42,5 +78,9 @@ int main(int argc, char* argv[])
 
     std::cout << "Second result is " << determineMaxSignalWithFeedback(p) << std::endl;
 
+    if(run_benchmark) {
+        benchmarkFeedbackModes(p);
+    }
+
     return 0;
 }
@@ -1,59 +1,185 @@
 #include <amp_settings.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <deque>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
 int determineMaxSignal(IntegerProgram const& p)
 {
     std::array<int, 5> phases;
     std::iota(begin(phases), end(phases), 0);
     int max_signal = 0;
+    // copy-assigning into the same programs each run reuses their buffers
+    std::vector<IntegerProgram> amps;
     do {
-        int signal = 0;
-        for (auto const& phase : phases) {
-            IntegerProgram ip = p;
-            ip.input.push_back(phase);
-            ip.input.push_back(signal);
-            executeProgram(ip);
-            assert(ip.pc == -1);
-            assert(ip.output.size() == 1);
-            signal = ip.output.back();
-        }
-        max_signal = std::max(max_signal, signal);
+        max_signal = std::max(max_signal, runAmps(p, phases, AmpMode::Chain, amps));
     } while (std::next_permutation(begin(phases), end(phases)));
     return max_signal;
 }
 
 int determineMaxSignalWithFeedback(IntegerProgram const& p)
 {
-    int constexpr n_amps = 5;
-    std::array<int, n_amps> phases;
+    std::array<int, 5> phases;
     std::iota(begin(phases), end(phases), 5);
     int max_signal = 0;
+    std::vector<IntegerProgram> amps;
     do {
-        int signal = 0;
-        std::vector<IntegerProgram> amps(n_amps, p);
-        for (int i = 0; i < n_amps; ++i) { amps[i].input.push_back(phases[i]); }
-        int done_count = 0;
-        for (int current_amp = 0; done_count != n_amps; current_amp = ((current_amp + 1) % n_amps)) {
-            IntegerProgram& ip = amps[current_amp];
+        max_signal = std::max(max_signal, runAmps(p, phases, AmpMode::Feedback, amps));
+    } while (std::next_permutation(begin(phases), end(phases)));
+    return max_signal;
+}
+
+int runAmps(IntegerProgram const& p, std::span<int const> phases, AmpMode mode, std::vector<IntegerProgram>& amps)
+{
+    int const n_amps = static_cast<int>(phases.size());
+    // a chain runs one amp after another, so a single program is enough
+    amps.resize((mode == AmpMode::Chain) ? 1 : phases.size(), p);
+    int signal = 0;
+    if (mode == AmpMode::Chain) {
+        IntegerProgram& ip = amps.front();
+        for (auto const& phase : phases) {
+            ip = p;
+            ip.input.push_back(phase);
             ip.input.push_back(signal);
-            assert(ip.pc >= 0);
             executeProgram(ip);
+            assert(ip.pc == -1);
             assert(ip.output.size() == 1);
             signal = ip.output.back();
-            ip.output.pop_back();
-            if (ip.pc == -1) {
-                // amp has finished processing
-                ++done_count;
-            } else {
-                // amp is awaiting input
-                assert(ip.pc == -4);
-                ip.pc = ip.resume_point;
+        }
+        return signal;
+    }
+    for (int i = 0; i < n_amps; ++i) {
+        amps[i] = p;
+        amps[i].input.push_back(phases[i]);
+    }
+    int done_count = 0;
+    for (int current_amp = 0; done_count != n_amps; current_amp = ((current_amp + 1) % n_amps)) {
+        IntegerProgram& ip = amps[current_amp];
+        ip.input.push_back(signal);
+        assert(ip.pc >= 0);
+        executeProgram(ip);
+        assert(ip.output.size() == 1);
+        signal = ip.output.back();
+        ip.output.pop_back();
+        if (ip.pc == -1) {
+            // amp has finished processing
+            ++done_count;
+        } else {
+            // amp is awaiting input
+            assert(ip.pc == -4);
+            ip.pc = ip.resume_point;
+        }
+    }
+    return signal;
+}
+
+std::vector<int> unrankPermutation(std::span<int const> set, std::uint64_t index)
+{
+    std::vector<int> remaining(set.begin(), set.end());
+    std::sort(begin(remaining), end(remaining));
+    std::vector<int> ret;
+    ret.reserve(remaining.size());
+    // factorial number system: the leading element advances every (n-1)! ranks
+    std::uint64_t block = 1;
+    for (std::uint64_t i = 2; i < remaining.size(); ++i) { block *= i; }
+    while (!remaining.empty()) {
+        std::uint64_t const digit = index / block;
+        assert(digit < remaining.size());
+        index %= block;
+        ret.push_back(remaining[digit]);
+        remaining.erase(begin(remaining) + digit);
+        if (remaining.size() > 1) { block /= remaining.size(); }
+    }
+    return ret;
+}
+
+AmpSearchResult searchMaxSignal(IntegerProgram const& p, std::span<int const> phase_set, AmpMode mode,
+                                unsigned n_threads)
+{
+    assert(!phase_set.empty() && (phase_set.size() <= 20));
+    std::uint64_t n_permutations = 1;
+    for (std::uint64_t i = 2; i <= phase_set.size(); ++i) { n_permutations *= i; }
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    std::uint64_t const block_size = std::max<std::uint64_t>(n_permutations / (8 * n_threads), 1);
+    std::uint64_t const n_blocks = (n_permutations + block_size - 1) / block_size;
+    std::atomic<std::uint64_t> next_block = 0;
+
+    AmpSearchResult ret{ 0, {} };
+    std::uint64_t best_rank = n_permutations;
+    std::mutex mtx;
+    auto const worker = [&]() {
+        std::vector<IntegerProgram> amps(phase_set.size(), p);
+        for (std::uint64_t block = next_block++; block < n_blocks; block = next_block++) {
+            std::uint64_t const first = block * block_size;
+            std::uint64_t const last = std::min(first + block_size, n_permutations);
+            std::vector<int> phases = unrankPermutation(phase_set, first);
+            int block_max = 0;
+            std::uint64_t block_best = last;
+            std::vector<int> block_phases;
+            for (std::uint64_t rank = first; rank < last; ++rank) {
+                int const signal = runAmps(p, phases, mode, amps);
+                if ((block_best == last) || (signal > block_max)) {
+                    block_max = signal;
+                    block_best = rank;
+                    block_phases = phases;
+                }
+                std::next_permutation(begin(phases), end(phases));
+            }
+            std::lock_guard lk(mtx);
+            if ((best_rank == n_permutations) || (block_max > ret.max_signal) ||
+                ((block_max == ret.max_signal) && (block_best < best_rank)))
+            {
+                ret.max_signal = block_max;
+                ret.phases = std::move(block_phases);
+                best_rank = block_best;
             }
         }
-        max_signal = std::max(max_signal, signal);
-    } while (std::next_permutation(begin(phases), end(phases)));
-    return max_signal;
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::min<std::uint64_t>(n_threads, n_blocks); ++i) { threads.emplace_back(worker); }
+    worker();
+    for (auto& t : threads) { t.join(); }
+    return ret;
+}
+
+int runAmpsPipelined(IntegerProgram const& p, std::span<int const> phases, AmpMode mode)
+{
+    std::size_t const n_amps = phases.size();
+    std::size_t constexpr queue_capacity = 1024;
+    // queue i feeds amp i; in feedback mode, the last amp feeds queue 0
+    std::deque<SpscQueue<int>> queues;
+    for (std::size_t i = 0; i < n_amps; ++i) { queues.emplace_back(queue_capacity); }
+    queues.front().tryPush(0);
+
+    int last_signal = 0;
+    auto const run_amp = [&](std::size_t amp_index) {
+        SpscQueue<int>& in = queues[amp_index];
+        bool const is_last = (amp_index == n_amps - 1);
+        SpscQueue<int>* out = (is_last && (mode == AmpMode::Chain)) ? nullptr : &queues[(amp_index + 1) % n_amps];
+        IntegerProgram ip = p;
+        ip.input.push_back(phases[amp_index]);
+        for (;;) {
+            executeProgram(ip);
+            for (int const signal : ip.output) {
+                if (out) { while (!out->tryPush(signal)) { std::this_thread::yield(); } }
+                if (is_last) { last_signal = signal; }
+            }
+            ip.output.clear();
+            if (ip.pc == -1) { break; }
+            assert(ip.pc == -4);
+            ip.pc = ip.resume_point;
+            std::optional<int> signal;
+            while (!(signal = in.tryPop())) { std::this_thread::yield(); }
+            ip.input.push_back(*signal);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < n_amps; ++i) { threads.emplace_back(run_amp, i); }
+    run_amp(0);
+    for (auto& t : threads) { t.join(); }
+    return last_signal;
 }
@@ -4,6 +4,13 @@
 #include <integer_program_mk2.hpp>
 
 #include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
 
 using AmpChain = std::array<IntegerProgram, 5>;
 
@@ -11,4 +18,75 @@ int determineMaxSignal(IntegerProgram const& p);
 
 int determineMaxSignalWithFeedback(IntegerProgram const& p);
 
+enum class AmpMode {
+    Chain,          ///< each amp runs once, feeding the next
+    Feedback        ///< the last amp feeds back into the first until all amps halt
+};
+
+/** Runs one amp per entry of phases, reusing the programs in amps as scratch space.
+ * Returns the signal produced by the last amp.
+ */
+int runAmps(IntegerProgram const& p, std::span<int const> phases, AmpMode mode, std::vector<IntegerProgram>& amps);
+
+struct AmpSearchResult {
+    int max_signal;
+    std::vector<int> phases;    ///< phase of each amp in the winning order
+};
+
+/** The permutation of the sorted, distinct elements of set with lexicographic rank index.
+ */
+std::vector<int> unrankPermutation(std::span<int const> set, std::uint64_t index);
+
+/** Tries every assignment of the distinct values in phase_set to amps, one amp per value.
+ * Permutations are handed out to n_threads threads in blocks of consecutive ranks; passing 0 for
+ * n_threads uses the hardware concurrency. Ties are resolved in favor of the lexicographically smallest order.
+ */
+AmpSearchResult searchMaxSignal(IntegerProgram const& p, std::span<int const> phase_set, AmpMode mode,
+                                unsigned n_threads = 0);
+
+/** Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ */
+template<typename T>
+class SpscQueue {
+private:
+    static std::size_t constexpr cache_line_size = 64;
+    std::vector<T> m_buffer;
+    std::size_t m_mask;
+    alignas(cache_line_size) std::atomic<std::size_t> m_head;   ///< next slot to pop, written by the consumer
+    alignas(cache_line_size) std::atomic<std::size_t> m_tail;   ///< next slot to push, written by the producer
+public:
+    /** Capacity must be a power of two.
+     */
+    explicit SpscQueue(std::size_t capacity)
+        :m_buffer(capacity), m_mask(capacity - 1), m_head(0), m_tail(0)
+    {
+        assert((capacity > 0) && ((capacity & m_mask) == 0));
+    }
+
+    bool tryPush(T const& v)
+    {
+        std::size_t const tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_buffer.size()) { return false; }
+        m_buffer[tail & m_mask] = v;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> tryPop()
+    {
+        std::size_t const head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) { return std::nullopt; }
+        T ret = m_buffer[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return ret;
+    }
+};
+
+/** Same result as runAmps(), but every amp runs on its own thread.
+ * Amps pass signals through SpscQueues, so amp k can work on one signal while amp k+1 is still processing
+ * the previous one. This only pays off for amp programs that do a lot of work per signal; for short programs
+ * the cost of starting the threads dominates.
+ */
+int runAmpsPipelined(IntegerProgram const& p, std::span<int const> phases, AmpMode mode);
+
 #endif
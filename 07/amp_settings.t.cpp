@@ -2,6 +2,12 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
 TEST_CASE("Amp Settings")
 {
     SECTION("program")
@@ -42,4 +48,96 @@ TEST_CASE("Amp Settings")
         auto p = parseInput(program);
         CHECK(determineMaxSignalWithFeedback(p) == 18216);
     }
+
+    SECTION("Unrank Permutation")
+    {
+        std::vector<int> const set{ 7, 5, 6 };
+        CHECK(unrankPermutation(set, 0) == std::vector<int>{ 5, 6, 7 });
+        CHECK(unrankPermutation(set, 1) == std::vector<int>{ 5, 7, 6 });
+        CHECK(unrankPermutation(set, 5) == std::vector<int>{ 7, 6, 5 });
+        std::vector<int> expected(6);
+        std::iota(begin(expected), end(expected), 0);
+        for (std::uint64_t rank = 0; rank < 720; ++rank) {
+            CHECK(unrankPermutation(expected, rank) == expected);
+            std::next_permutation(begin(expected), end(expected));
+        }
+        CHECK(unrankPermutation(std::vector<int>{ 3 }, 0) == std::vector<int>{ 3 });
+    }
+
+    SECTION("Parallel Search")
+    {
+        std::vector<int> const phases{ 0, 1, 2, 3, 4 };
+        std::vector<int> const feedback_phases{ 9, 8, 7, 6, 5 };
+        char const program[] = "3,15,3,16,1002,16,10,16,1,16,15,15,4,15,99,0,0";
+        char const feedback_program[] = "3,26,1001,26,-4,26,3,27,1002,27,2,27,1,27,26,"
+                                        "27,4,27,1001,28,-1,28,1005,28,6,99,0,0,5";
+        auto const p = parseInput(program);
+        auto const pf = parseInput(feedback_program);
+        for (unsigned n_threads : { 1, 3 }) {
+            auto const r = searchMaxSignal(p, phases, AmpMode::Chain, n_threads);
+            CHECK(r.max_signal == 43210);
+            CHECK(r.phases == std::vector<int>{ 4, 3, 2, 1, 0 });
+            auto const rf = searchMaxSignal(pf, feedback_phases, AmpMode::Feedback, n_threads);
+            CHECK(rf.max_signal == 139629729);
+            CHECK(rf.phases == std::vector<int>{ 9, 8, 7, 6, 5 });
+        }
+
+        // any number of amps; the program appends each phase as a decimal digit to the signal
+        auto const r3 = searchMaxSignal(p, std::vector<int>{ 2, 7, 5 }, AmpMode::Chain, 2);
+        CHECK(r3.max_signal == 752);
+        CHECK(r3.phases == std::vector<int>{ 7, 5, 2 });
+        auto const r7 = searchMaxSignal(p, std::vector<int>{ 0, 1, 2, 3, 4, 5, 6 }, AmpMode::Chain, 4);
+        CHECK(r7.max_signal == 6543210);
+        CHECK(r7.phases == std::vector<int>{ 6, 5, 4, 3, 2, 1, 0 });
+    }
+
+    SECTION("Spsc Queue")
+    {
+        SpscQueue<int> q(4);
+        CHECK(!q.tryPop());
+        for (int i = 0; i < 4; ++i) { CHECK(q.tryPush(i)); }
+        CHECK(!q.tryPush(4));
+        CHECK(q.tryPop() == 0);
+        CHECK(q.tryPush(4));
+        for (int i = 1; i < 5; ++i) { CHECK(q.tryPop() == i); }
+        CHECK(!q.tryPop());
+
+        SpscQueue<int> q2(8);
+        int const n = 100000;
+        std::thread producer([&q2]() {
+                for (int i = 0; i < n; ++i) { while (!q2.tryPush(i)) { std::this_thread::yield(); } }
+            });
+        bool in_order = true;
+        for (int i = 0; i < n; ++i) {
+            std::optional<int> v;
+            while (!(v = q2.tryPop())) { std::this_thread::yield(); }
+            in_order = in_order && (*v == i);
+        }
+        producer.join();
+        CHECK(in_order);
+    }
+
+    SECTION("Pipelined Amps")
+    {
+        char const program[] = "3,15,3,16,1002,16,10,16,1,16,15,15,4,15,99,0,0";
+        char const feedback_program[] = "3,52,1001,52,-5,52,3,53,1,52,56,54,1007,54,5,55,1005,55,26,1001,54,"
+                                        "-5,54,1105,1,12,1,53,54,53,1008,54,0,55,1001,55,1,55,2,53,55,53,4,"
+                                        "53,1001,56,-1,56,1005,56,6,99,0,0,0,0,10";
+        auto const p = parseInput(program);
+        auto const pf = parseInput(feedback_program);
+        std::vector<IntegerProgram> amps;
+        std::vector<int> phases{ 0, 1, 2, 3, 4 };
+        std::vector<int> feedback_phases{ 5, 6, 7, 8, 9 };
+        do {
+            CHECK(runAmpsPipelined(p, phases, AmpMode::Chain) == runAmps(p, phases, AmpMode::Chain, amps));
+        } while (std::next_permutation(begin(phases), end(phases)));
+        CHECK(amps.size() == 1);
+        for (int i = 0; i < 10; ++i) {
+            CHECK(runAmpsPipelined(pf, feedback_phases, AmpMode::Feedback) ==
+                  runAmps(pf, feedback_phases, AmpMode::Feedback, amps));
+            std::next_permutation(begin(feedback_phases), end(feedback_phases));
+        }
+        CHECK(runAmpsPipelined(pf, std::vector<int>{ 9, 7, 8, 5, 6 }, AmpMode::Feedback) == 18216);
+        CHECK(runAmpsPipelined(p, std::vector<int>{ 4, 3, 2, 1, 0 }, AmpMode::Chain) == 43210);
+    }
 }
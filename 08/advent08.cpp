@@ -36,11 +36,15 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    auto const img = parseInput(*input, 25, 6);
+    auto const img = parsePackedImage(*input, 25, 6);
+    if(!img) {
+        std::cerr << "Input is not a valid 25x6 image." << std::endl;
+        return 1;
+    }
 
-    std::cout << "First result is " << imageChecksum(img) << std::endl;
+    std::cout << "First result is " << imageChecksum(*img) << std::endl;
 
-    Image const collapsed = collapseLayers(img);
+    PackedImage const collapsed = collapseLayers(*img);
     std::cout << "Second result is\n" << collapsed;
 
     return 0;
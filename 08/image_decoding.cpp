@@ -1,9 +1,18 @@
 #include <image_decoding.hpp>
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <iterator>
+#include <limits>
 #include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#   include <immintrin.h>
+#endif
 
 Image parseInput(std::string_view input, int width, int height)
 {
@@ -59,7 +68,7 @@ Image collapseLayers(Image const& img)
     Image ret{ img.width, img.height, { std::vector<int>(img.width* img.height) } };
     for (int idx = 0; idx < img.width * img.height; ++idx) {
         ret.layers[0][idx] = std::accumulate(img.layers.rbegin(), img.layers.rend(), (int)Color::Transparent,
-            [idx](int src_color, std::vector<int> blend_layer) -> int {
+            [idx](int src_color, std::vector<int> const& blend_layer) -> int {
                 int const dst_color = blend_layer[idx];
                 return (dst_color == Color::Transparent) ? src_color : dst_color;
             });
@@ -84,3 +93,343 @@ std::ostream& operator<<(std::ostream& os, Image const& img)
     }
     return os;
 }
+
+namespace {
+int pixelCount(PackedImage const& img)
+{
+    return img.width * img.height;
+}
+
+int countBits(std::span<std::uint64_t const> plane)
+{
+    int ret = 0;
+    for (auto const& w : plane) { ret += std::popcount(w); }
+    return ret;
+}
+
+int countBlackBits(std::span<std::uint64_t const> opaque, std::span<std::uint64_t const> white)
+{
+    int ret = 0;
+    for (std::size_t i = 0; i < opaque.size(); ++i) { ret += std::popcount(opaque[i] & ~white[i]); }
+    return ret;
+}
+
+std::uint64_t lastWordMask(int n_pixels)
+{
+    return ((n_pixels % 64) == 0) ? ~std::uint64_t{ 0 } : ((std::uint64_t{ 1 } << (n_pixels % 64)) - 1);
+}
+}
+
+int wordsPerPlane(PackedImage const& img)
+{
+    return (pixelCount(img) + 63) / 64;
+}
+
+std::span<std::uint64_t const> opaquePlane(PackedImage const& img, int layer)
+{
+    assert((layer >= 0) && (layer < img.n_layers));
+    return std::span<std::uint64_t const>(img.planes).subspan(2 * layer * wordsPerPlane(img), wordsPerPlane(img));
+}
+
+std::span<std::uint64_t const> whitePlane(PackedImage const& img, int layer)
+{
+    assert((layer >= 0) && (layer < img.n_layers));
+    return std::span<std::uint64_t const>(img.planes).subspan((2 * layer + 1) * wordsPerPlane(img), wordsPerPlane(img));
+}
+
+std::optional<PackedImage> parsePackedImage(std::string_view input, int width, int height)
+{
+    assert((width > 0) && (height > 0));
+    if (!input.empty() && (input.back() == '\n')) { input.remove_suffix(1); }
+    PackedImage ret{ width, height, 0, {} };
+    std::size_t const n_pixels = pixelCount(ret);
+    if (input.size() % n_pixels != 0) { return std::nullopt; }
+    ret.n_layers = static_cast<int>(input.size() / n_pixels);
+    std::size_t const n_words = wordsPerPlane(ret);
+    ret.planes.resize(2 * n_words * ret.n_layers);
+    for (int layer = 0; layer < ret.n_layers; ++layer) {
+        std::string_view const pixels = input.substr(layer * n_pixels, n_pixels);
+        std::uint64_t* opaque = ret.planes.data() + 2 * layer * n_words;
+        std::uint64_t* white = opaque + n_words;
+        for (std::size_t i = 0; i < n_pixels; ++i) {
+            char const c = pixels[i];
+            if ((c < '0') || (c > '2')) { return std::nullopt; }
+            std::uint64_t const bit = std::uint64_t{ 1 } << (i % 64);
+            if (c != '2') { opaque[i / 64] |= bit; }
+            if (c == '1') { white[i / 64] |= bit; }
+        }
+    }
+    return ret;
+}
+
+Color::Color_Values getPixel(PackedImage const& img, int layer, int index)
+{
+    assert((index >= 0) && (index < pixelCount(img)));
+    std::uint64_t const bit = std::uint64_t{ 1 } << (index % 64);
+    if ((opaquePlane(img, layer)[index / 64] & bit) == 0) { return Color::Transparent; }
+    return ((whitePlane(img, layer)[index / 64] & bit) != 0) ? Color::White : Color::Black;
+}
+
+Image unpackImage(PackedImage const& img)
+{
+    Image ret{ img.width, img.height, {} };
+    ret.layers.reserve(img.n_layers);
+    for (int layer = 0; layer < img.n_layers; ++layer) {
+        std::vector<int> pixels(pixelCount(img));
+        for (int i = 0; i < pixelCount(img); ++i) { pixels[i] = getPixel(img, layer, i); }
+        ret.layers.emplace_back(std::move(pixels));
+    }
+    return ret;
+}
+
+int layerWithFewestZeros(PackedImage const& img)
+{
+    int ret = 0;
+    int min_zeros = std::numeric_limits<int>::max();
+    for (int layer = 0; layer < img.n_layers; ++layer) {
+        int const zeros = countBlackBits(opaquePlane(img, layer), whitePlane(img, layer));
+        if (zeros < min_zeros) {
+            min_zeros = zeros;
+            ret = layer;
+        }
+    }
+    return ret;
+}
+
+int imageChecksum(PackedImage const& img)
+{
+    int const layer = layerWithFewestZeros(img);
+    int const n_ones = countBits(whitePlane(img, layer));
+    int const n_twos = pixelCount(img) - countBits(opaquePlane(img, layer));
+    return n_ones * n_twos;
+}
+
+LayerCompositor::LayerCompositor(int width, int height)
+    :m_width(width), m_height(height), m_layerCount(0),
+     m_resolved((width * height + 63) / 64), m_white(m_resolved.size()), m_unresolvedWords(m_resolved.size())
+{
+    assert((width > 0) && (height > 0));
+}
+
+bool LayerCompositor::addLayer(std::span<std::uint64_t const> opaque, std::span<std::uint64_t const> white)
+{
+    assert((opaque.size() == m_resolved.size()) && (white.size() == m_resolved.size()));
+    ++m_layerCount;
+    if (isResolved()) { return true; }
+    std::size_t const n_words = m_resolved.size();
+    std::uint64_t const last_mask = lastWordMask(m_width * m_height);
+    m_unresolvedWords = 0;
+    for (std::size_t i = 0; i < n_words; ++i) {
+        std::uint64_t const mask = (i + 1 == n_words) ? last_mask : ~std::uint64_t{ 0 };
+        std::uint64_t const revealed = opaque[i] & ~m_resolved[i];
+        m_white[i] |= revealed & white[i];
+        m_resolved[i] |= revealed;
+        if ((m_resolved[i] & mask) != mask) { ++m_unresolvedWords; }
+    }
+    return isResolved();
+}
+
+bool LayerCompositor::isResolved() const
+{
+    return m_unresolvedWords == 0;
+}
+
+int LayerCompositor::layerCount() const
+{
+    return m_layerCount;
+}
+
+PackedImage LayerCompositor::result() const
+{
+    PackedImage ret{ m_width, m_height, 1, m_resolved };
+    ret.planes.insert(ret.planes.end(), m_white.begin(), m_white.end());
+    return ret;
+}
+
+PackedImage collapseLayers(PackedImage const& img)
+{
+    LayerCompositor compositor(img.width, img.height);
+    for (int layer = 0; layer < img.n_layers; ++layer) {
+        if (compositor.addLayer(opaquePlane(img, layer), whitePlane(img, layer))) { break; }
+    }
+    return compositor.result();
+}
+
+std::ostream& operator<<(std::ostream& os, PackedImage const& img)
+{
+    assert(img.n_layers == 1);
+    return os << unpackImage(img);
+}
+
+bool operator==(LayerHistogram const& lhs, LayerHistogram const& rhs)
+{
+    return (lhs.zeros == rhs.zeros) && (lhs.ones == rhs.ones) && (lhs.twos == rhs.twos);
+}
+
+LayerHistogram countDigits(std::string_view pixels)
+{
+    LayerHistogram ret{ 0, 0, 0 };
+    std::size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#   if defined(__AVX2__)
+    using Vector = __m256i;
+    std::size_t constexpr lanes = 32;
+    auto const load = [](char const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); };
+    auto const splat = [](char c) { return _mm256_set1_epi8(c); };
+    auto const zero = []() { return _mm256_setzero_si256(); };
+    auto const count_matches = [](Vector acc, Vector v, Vector digit) {
+        // matching bytes compare to -1, so subtracting increments the byte counter
+        return _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, digit));
+    };
+    auto const horizontal_sum = [](Vector acc) {
+        __m256i const sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        return static_cast<int>(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                                _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+    };
+#   else
+    using Vector = __m128i;
+    std::size_t constexpr lanes = 16;
+    auto const load = [](char const* p) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); };
+    auto const splat = [](char c) { return _mm_set1_epi8(c); };
+    auto const zero = []() { return _mm_setzero_si128(); };
+    auto const count_matches = [](Vector acc, Vector v, Vector digit) {
+        return _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, digit));
+    };
+    auto const horizontal_sum = [](Vector acc) {
+        __m128i const sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        return _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+    };
+#   endif
+    Vector const digit0 = splat('0');
+    Vector const digit1 = splat('1');
+    Vector const digit2 = splat('2');
+    // byte counters overflow after 255 blocks
+    std::size_t constexpr max_blocks = 255;
+    while (i + lanes <= pixels.size()) {
+        Vector acc0 = zero();
+        Vector acc1 = zero();
+        Vector acc2 = zero();
+        for (std::size_t b = 0; (b < max_blocks) && (i + lanes <= pixels.size()); ++b, i += lanes) {
+            Vector const v = load(pixels.data() + i);
+            acc0 = count_matches(acc0, v, digit0);
+            acc1 = count_matches(acc1, v, digit1);
+            acc2 = count_matches(acc2, v, digit2);
+        }
+        ret.zeros += horizontal_sum(acc0);
+        ret.ones += horizontal_sum(acc1);
+        ret.twos += horizontal_sum(acc2);
+    }
+#endif
+    for (; i < pixels.size(); ++i) {
+        ret.zeros += (pixels[i] == '0');
+        ret.ones += (pixels[i] == '1');
+        ret.twos += (pixels[i] == '2');
+    }
+    return ret;
+}
+
+std::vector<LayerHistogram> layerHistograms(std::string_view input, int width, int height, unsigned n_threads)
+{
+    if ((width <= 0) || (height <= 0)) { throw std::invalid_argument("Invalid image dimensions"); }
+    if (!input.empty() && (input.back() == '\n')) { input.remove_suffix(1); }
+    std::size_t const n_pixels = static_cast<std::size_t>(width) * height;
+    if (input.size() % n_pixels != 0) { throw std::invalid_argument("Input does not consist of whole layers"); }
+    std::size_t const n_layers = input.size() / n_pixels;
+    std::vector<LayerHistogram> ret(n_layers);
+    auto const count_layers = [&ret, input, n_pixels](std::size_t first, std::size_t last) {
+        for (std::size_t layer = first; layer < last; ++layer) { ret[layer] = countDigits(input.substr(layer * n_pixels, n_pixels)); }
+    };
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    std::size_t const slice = (n_layers + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (std::size_t first = slice; first < n_layers; first += slice) {
+        threads.emplace_back(count_layers, first, std::min(first + slice, n_layers));
+    }
+    count_layers(0, std::min(slice, n_layers));
+    for (auto& t : threads) { t.join(); }
+    return ret;
+}
+
+int layerWithFewestZeros(std::span<LayerHistogram const> histograms)
+{
+    return static_cast<int>(std::distance(begin(histograms), std::min_element(begin(histograms), end(histograms),
+        [](LayerHistogram const& lhs, LayerHistogram const& rhs) { return lhs.zeros < rhs.zeros; })));
+}
+
+int imageChecksum(std::span<LayerHistogram const> histograms)
+{
+    LayerHistogram const& h = histograms[layerWithFewestZeros(histograms)];
+    return h.ones * h.twos;
+}
+
+StreamingImageDecoder::StreamingImageDecoder(int width, int height)
+    :m_width(width), m_height(height), m_layerCount(0), m_failed(false), m_position(0), m_current{ 0, 0, 0 },
+     m_opaque((width * height + 63) / 64), m_white(m_opaque.size()), m_compositor(width, height)
+{}
+
+bool StreamingImageDecoder::feed(std::string_view chunk)
+{
+    if (m_failed) { return false; }
+    std::size_t const n_pixels = static_cast<std::size_t>(m_width) * m_height;
+    while (!chunk.empty()) {
+        if (chunk.front() == '\n') {
+            chunk.remove_prefix(1);
+            continue;
+        }
+        // the longest run of pixels that neither contains a newline nor crosses a layer boundary
+        std::size_t const run_length = std::min({ chunk.find('\n'), chunk.size(), n_pixels - m_position });
+        std::string_view const run = chunk.substr(0, run_length);
+        chunk.remove_prefix(run_length);
+
+        LayerHistogram const h = countDigits(run);
+        if (static_cast<std::size_t>(h.zeros + h.ones + h.twos) != run.size()) {
+            m_failed = true;
+            return false;
+        }
+        m_current.zeros += h.zeros;
+        m_current.ones += h.ones;
+        m_current.twos += h.twos;
+        // layers behind a fully resolved image cannot change it, so their planes are not needed
+        if (!m_compositor.isResolved()) {
+            for (std::size_t i = 0; i < run.size(); ++i) {
+                std::size_t const pixel = m_position + i;
+                std::uint64_t const bit = std::uint64_t{ 1 } << (pixel % 64);
+                if (run[i] != '2') { m_opaque[pixel / 64] |= bit; }
+                if (run[i] == '1') { m_white[pixel / 64] |= bit; }
+            }
+        }
+        m_position += run.size();
+
+        if (m_position == n_pixels) {
+            if (!m_fewestZeros || (m_current.zeros < m_fewestZeros->zeros)) { m_fewestZeros = m_current; }
+            m_compositor.addLayer(m_opaque, m_white);
+            ++m_layerCount;
+            m_position = 0;
+            m_current = LayerHistogram{ 0, 0, 0 };
+            std::fill(begin(m_opaque), end(m_opaque), 0);
+            std::fill(begin(m_white), end(m_white), 0);
+        }
+    }
+    return true;
+}
+
+int StreamingImageDecoder::layerCount() const
+{
+    return m_layerCount;
+}
+
+bool StreamingImageDecoder::atLayerBoundary() const
+{
+    return m_position == 0;
+}
+
+std::optional<int> StreamingImageDecoder::checksum() const
+{
+    if (!m_fewestZeros) { return std::nullopt; }
+    return m_fewestZeros->ones * m_fewestZeros->twos;
+}
+
+PackedImage StreamingImageDecoder::image() const
+{
+    return m_compositor.result();
+}
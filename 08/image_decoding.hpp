@@ -1,7 +1,10 @@
 #ifndef ADVENT_OF_CODE_08_IMAGE_DECODING_HPP_INCLUDE_GUARD
 #define ADVENT_OF_CODE_08_IMAGE_DECODING_HPP_INCLUDE_GUARD
 
+#include <cstdint>
 #include <iosfwd>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -29,4 +32,121 @@ Image collapseLayers(Image const& img);
 
 std::ostream& operator<<(std::ostream& os, Image const& img);
 
+/** Image with layers stored as bitplanes, one bit per pixel and plane, in a single buffer.
+ * Every layer has an opaque plane (pixel is not Transparent) followed by a white plane (pixel is White).
+ * Each plane is padded with zero bits to a whole number of 64 bit words.
+ */
+struct PackedImage {
+    int width;
+    int height;
+    int n_layers;
+    std::vector<std::uint64_t> planes;
+};
+
+int wordsPerPlane(PackedImage const& img);
+
+std::span<std::uint64_t const> opaquePlane(PackedImage const& img, int layer);
+
+std::span<std::uint64_t const> whitePlane(PackedImage const& img, int layer);
+
+/** Returns std::nullopt if the input has pixels other than Black, White or Transparent or ends within a layer.
+ */
+std::optional<PackedImage> parsePackedImage(std::string_view input, int width, int height);
+
+Color::Color_Values getPixel(PackedImage const& img, int layer, int index);
+
+Image unpackImage(PackedImage const& img);
+
+int layerWithFewestZeros(PackedImage const& img);
+
+int imageChecksum(PackedImage const& img);
+
+/** Composites layers front to back on packed bitplanes, a whole layer at a time.
+ * Each added layer only contributes to pixels not already covered by an opaque pixel of a layer in front of it.
+ */
+class LayerCompositor {
+private:
+    int m_width;
+    int m_height;
+    int m_layerCount;
+    std::vector<std::uint64_t> m_resolved;      ///< pixels covered by an opaque pixel
+    std::vector<std::uint64_t> m_white;
+    std::size_t m_unresolvedWords;              ///< number of words in m_resolved that still have pixels missing
+public:
+    LayerCompositor(int width, int height);
+    /** Adds a layer behind all layers added so far. Returns true once every pixel is resolved,
+     * after which further layers have no effect.
+     */
+    bool addLayer(std::span<std::uint64_t const> opaque, std::span<std::uint64_t const> white);
+    bool isResolved() const;
+    int layerCount() const;
+    /** Single layer image of the composited layers. Pixels that no layer covers remain Transparent.
+     */
+    PackedImage result() const;
+};
+
+/** Stops reading layers as soon as every pixel is opaque.
+ */
+PackedImage collapseLayers(PackedImage const& img);
+
+std::ostream& operator<<(std::ostream& os, PackedImage const& img);
+
+struct LayerHistogram {
+    int zeros;
+    int ones;
+    int twos;
+};
+
+bool operator==(LayerHistogram const& lhs, LayerHistogram const& rhs);
+
+/** Counts the digits 0, 1 and 2 in a run of raw ASCII pixels, 16 or 32 bytes at a time where SIMD is available.
+ */
+LayerHistogram countDigits(std::string_view pixels);
+
+/** Histograms of all layers, read directly from the raw digit string. A trailing newline is ignored.
+ * Throws std::invalid_argument if the input does not split into whole layers.
+ * Layers are split evenly across n_threads threads; passing 0 uses the hardware concurrency.
+ */
+std::vector<LayerHistogram> layerHistograms(std::string_view input, int width, int height, unsigned n_threads = 0);
+
+int layerWithFewestZeros(std::span<LayerHistogram const> histograms);
+
+int imageChecksum(std::span<LayerHistogram const> histograms);
+
+/** Decodes an image that arrives in chunks of arbitrary size, holding only one layer's worth of state.
+ * Layer boundaries may fall anywhere within a chunk or between chunks; newlines are skipped.
+ * The checksum of the layer with the fewest zeros and the composited image are updated as layers complete.
+ */
+class StreamingImageDecoder {
+private:
+    int m_width;
+    int m_height;
+    int m_layerCount;
+    bool m_failed;
+    std::size_t m_position;                         ///< pixels received for the current layer
+    LayerHistogram m_current;
+    std::optional<LayerHistogram> m_fewestZeros;
+    std::vector<std::uint64_t> m_opaque;            ///< planes of the current layer
+    std::vector<std::uint64_t> m_white;
+    LayerCompositor m_compositor;
+public:
+    StreamingImageDecoder(int width, int height);
+    /** Returns false if the chunk has pixels other than Black, White or Transparent.
+     * The decoder rejects all further input after that.
+     */
+    bool feed(std::string_view chunk);
+    /** Number of complete layers received.
+     */
+    int layerCount() const;
+    /** True if no partial layer is pending.
+     */
+    bool atLayerBoundary() const;
+    /** Checksum as imageChecksum() over the complete layers received; std::nullopt before the first one.
+     */
+    std::optional<int> checksum() const;
+    /** Composited image of the complete layers received.
+     */
+    PackedImage image() const;
+};
+
 #endif
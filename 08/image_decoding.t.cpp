@@ -2,7 +2,11 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 TEST_CASE("Image Decoding")
 {
@@ -47,4 +51,192 @@ TEST_CASE("Image Decoding")
         sstr << Image{ 2,2, {std::vector<int>{0,1,2,1}} };
         CHECK(sstr.str() == ".#\n #\n");
     }
+
+    SECTION("Packed Image")
+    {
+        auto const img = parsePackedImage("0222112222120000\n", 2, 2);
+        REQUIRE(img);
+        CHECK(img->width == 2);
+        CHECK(img->height == 2);
+        CHECK(img->n_layers == 4);
+        CHECK(wordsPerPlane(*img) == 1);
+        CHECK(img->planes.size() == 8);
+        CHECK(opaquePlane(*img, 0)[0] == 0b0001);
+        CHECK(whitePlane(*img, 0)[0] == 0b0000);
+        CHECK(opaquePlane(*img, 1)[0] == 0b0011);
+        CHECK(whitePlane(*img, 1)[0] == 0b0011);
+        CHECK(getPixel(*img, 2, 2) == Color::White);
+        CHECK(getPixel(*img, 2, 1) == Color::Transparent);
+        CHECK(getPixel(*img, 3, 3) == Color::Black);
+        Image const unpacked = unpackImage(*img);
+        CHECK(unpacked.layers == parseInput("0222112222120000\n", 2, 2).layers);
+
+        CHECK(!parsePackedImage("123456789012\n", 3, 2));
+        CHECK(!parsePackedImage("01201\n", 3, 2));
+        CHECK(parsePackedImage("012012", 3, 2));
+
+        // layers that span several words
+        std::string large;
+        for (int i = 0; i < 3 * 100 * 7; ++i) { large.push_back(static_cast<char>('0' + (i * i / 3) % 3)); }
+        large.push_back('\n');
+        auto const large_img = parsePackedImage(large, 100, 7);
+        REQUIRE(large_img);
+        CHECK(wordsPerPlane(*large_img) == 11);
+        CHECK(unpackImage(*large_img).layers == parseInput(large, 100, 7).layers);
+    }
+
+    SECTION("Packed Checksum")
+    {
+        auto const check_checksum = [](std::string_view input, int width, int height) {
+            auto const packed = parsePackedImage(input, width, height);
+            REQUIRE(packed);
+            Image const img = parseInput(input, width, height);
+            CHECK(layerWithFewestZeros(*packed) == layerWithFewestZeros(img));
+            CHECK(imageChecksum(*packed) == imageChecksum(img));
+        };
+        check_checksum("1020022200\n", 1, 2);
+        check_checksum("010012221022\n", 2, 2);
+        CHECK(imageChecksum(*parsePackedImage("010012221022\n", 2, 2)) == 3);
+        std::string large;
+        for (int i = 0; i < 5 * 25 * 6; ++i) { large.push_back(static_cast<char>('0' + (i * 7 + i / 13) % 3)); }
+        large.push_back('\n');
+        check_checksum(large, 25, 6);
+    }
+
+    SECTION("Packed Compositing")
+    {
+        auto const img = parsePackedImage("0222112222120000\n", 2, 2);
+        REQUIRE(img);
+        PackedImage const collapsed = collapseLayers(*img);
+        CHECK(collapsed.n_layers == 1);
+        REQUIRE(unpackImage(collapsed).layers.size() == 1);
+        CHECK(unpackImage(collapsed).layers[0] == std::vector<int>{0, 1, 1, 0});
+        std::stringstream sstr;
+        sstr << collapsed;
+        CHECK(sstr.str() == ".#\n#.\n");
+
+        LayerCompositor compositor(2, 2);
+        CHECK(!compositor.addLayer(opaquePlane(*img, 0), whitePlane(*img, 0)));
+        CHECK(!compositor.addLayer(opaquePlane(*img, 1), whitePlane(*img, 1)));
+        CHECK(!compositor.addLayer(opaquePlane(*img, 2), whitePlane(*img, 2)));
+        CHECK(!compositor.isResolved());
+        CHECK(compositor.addLayer(opaquePlane(*img, 3), whitePlane(*img, 3)));
+        CHECK(compositor.isResolved());
+        CHECK(compositor.layerCount() == 4);
+        // layers behind a fully opaque image have no effect
+        CHECK(compositor.addLayer(opaquePlane(*img, 0), whitePlane(*img, 0)));
+        CHECK(compositor.result().planes == collapsed.planes);
+
+        // compositing stops at the first layer that resolves all pixels
+        auto const early = parsePackedImage("2201101112\n", 2, 1);
+        REQUIRE(early);
+        CHECK(unpackImage(collapseLayers(*early)).layers[0] == std::vector<int>{0, 1});
+
+        // pixels never covered stay transparent
+        auto const partial = parsePackedImage("2212\n", 2, 1);
+        REQUIRE(partial);
+        CHECK(unpackImage(collapseLayers(*partial)).layers[0] == std::vector<int>{1, 2});
+
+        // multi-word planes against the scalar reference
+        std::string large;
+        for (int i = 0; i < 9 * 100 * 7; ++i) { large.push_back(static_cast<char>('0' + ((i % 5 == 0) ? (i / 7) % 2 : 2))); }
+        large.push_back('\n');
+        auto const large_img = parsePackedImage(large, 100, 7);
+        REQUIRE(large_img);
+        CHECK(unpackImage(collapseLayers(*large_img)).layers == collapseLayers(parseInput(large, 100, 7)).layers);
+    }
+
+    SECTION("Digit Histogram")
+    {
+        CHECK(countDigits("") == LayerHistogram{ 0, 0, 0 });
+        CHECK(countDigits("0120") == LayerHistogram{ 2, 1, 1 });
+        CHECK(countDigits("123456789012") == LayerHistogram{ 1, 2, 2 });
+        // long runs go through the vector loop, including more blocks than fit in byte counters
+        std::string const long_run(100000, '1');
+        CHECK(countDigits(long_run) == LayerHistogram{ 0, 100000, 0 });
+        std::string mixed;
+        for (int i = 0; i < 10007; ++i) { mixed.push_back(static_cast<char>('0' + (i * i) % 4)); }
+        auto const reference = [](std::string_view pixels) {
+            LayerHistogram ret{ 0, 0, 0 };
+            for (char c : pixels) {
+                ret.zeros += (c == '0');
+                ret.ones += (c == '1');
+                ret.twos += (c == '2');
+            }
+            return ret;
+        };
+        CHECK(countDigits(mixed) == reference(mixed));
+        for (std::size_t offset : { 1, 3, 17, 33 }) {
+            for (std::size_t length : { 15, 16, 31, 32, 33, 150, 4111 }) {
+                std::string_view const run = std::string_view(mixed).substr(offset, length);
+                CHECK(countDigits(run) == reference(run));
+            }
+        }
+    }
+
+    SECTION("Layer Histograms")
+    {
+        auto const h = layerHistograms(sample_input, 3, 2);
+        REQUIRE(h.size() == 2);
+        CHECK(h[0] == LayerHistogram{ 0, 1, 1 });
+        CHECK(h[1] == LayerHistogram{ 1, 1, 1 });
+        CHECK(layerWithFewestZeros(layerHistograms("1020022200\n", 1, 2)) == 3);
+        CHECK(imageChecksum(layerHistograms("010012221022\n", 2, 2)) == 3);
+        CHECK_THROWS_AS(layerHistograms("0100122210\n", 2, 2), std::invalid_argument);
+        CHECK_THROWS_AS(layerHistograms("0100", 0, 2), std::invalid_argument);
+
+        std::string large;
+        for (int i = 0; i < 37 * 25 * 6; ++i) { large.push_back(static_cast<char>('0' + (i * 7 + i / 11) % 3)); }
+        large.push_back('\n');
+        Image const img = parseInput(large, 25, 6);
+        for (unsigned n_threads : { 1, 4, 0 }) {
+            auto const hist = layerHistograms(large, 25, 6, n_threads);
+            REQUIRE(hist.size() == img.layers.size());
+            CHECK(layerWithFewestZeros(hist) == layerWithFewestZeros(img));
+            CHECK(imageChecksum(hist) == imageChecksum(img));
+        }
+    }
+
+    SECTION("Streaming Decoder")
+    {
+        StreamingImageDecoder decoder(2, 2);
+        CHECK(!decoder.checksum());
+        CHECK(decoder.feed("022"));
+        CHECK(!decoder.atLayerBoundary());
+        CHECK(decoder.feed("2112"));
+        CHECK(decoder.layerCount() == 1);
+        CHECK(decoder.checksum() == 0);
+        CHECK(decoder.feed(""));
+        CHECK(decoder.feed("222120000\n"));
+        CHECK(decoder.atLayerBoundary());
+        CHECK(decoder.layerCount() == 4);
+        CHECK(decoder.checksum() == imageChecksum(parseInput("0222112222120000\n", 2, 2)));
+        CHECK(unpackImage(decoder.image()).layers[0] == std::vector<int>{0, 1, 1, 0});
+
+        CHECK(!decoder.feed("0123"));
+        CHECK(!decoder.feed("0000"));
+        CHECK(decoder.layerCount() == 4);
+
+        // every chunk size, including chunks split around newlines
+        std::string large;
+        for (int i = 0; i < 23 * 25 * 6; ++i) {
+            large.push_back(static_cast<char>('0' + (i * 7 + i / 11) % 3));
+            if (i % 97 == 0) { large.push_back('\n'); }
+        }
+        std::string large_clean = large;
+        large_clean.erase(std::remove(begin(large_clean), end(large_clean), '\n'), end(large_clean));
+        large_clean.push_back('\n');
+        Image const img = parseInput(large_clean, 25, 6);
+        auto const expected_image = collapseLayers(img).layers;
+        for (std::size_t chunk_size : { 1, 2, 7, 149, 150, 151, 1000, 100000 }) {
+            StreamingImageDecoder d(25, 6);
+            for (std::size_t i = 0; i < large.size(); i += chunk_size) {
+                CHECK(d.feed(std::string_view(large).substr(i, chunk_size)));
+            }
+            CHECK(d.atLayerBoundary());
+            CHECK(d.layerCount() == 23);
+            CHECK(d.checksum() == imageChecksum(img));
+            CHECK(unpackImage(d.image()).layers == expected_image);
+        }
+    }
 }
@@ -36,8 +36,7 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    auto map = parseInput(*input);
-    determineLinesOfSight(map);
+    auto const map = parseInput(*input);
 
     auto const [visible, index] = bestVantagePoint(map);
 
@@ -3,8 +3,11 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <numeric>
 #include <ostream>
+#include <thread>
+#include <unordered_set>
 
 Vector2::Vector2()
     :x(0), y(0)
@@ -74,31 +77,52 @@ void determineLinesOfSight(Map& m)
     }
 }
 
-int asteroidsVisibleFrom(Map& m, std::size_t origin_index)
+namespace {
+std::uint64_t packAngle(Vector2 const& angle)
 {
-    assert(origin_index < m.lines_of_sight.size());
-    auto const& lines = m.lines_of_sight[origin_index];
-    return static_cast<int>(std::count_if(lines.begin(), lines.end(), [&lines](Line const& l) {
-        if (l.distance == 0) {
-            // don't count yourself
-            return false;
-        }
-        auto closer = std::find_if(lines.begin(), lines.end(),
-            [&l](Line const& l2) { return (l.angle == l2.angle) && (l.distance < l2.distance); });
-        if (closer != lines.end()) {
-            // line of sight is blocked;
-            return false;
-        }
-        return true;
-    }));
+    return (std::uint64_t{ static_cast<std::uint32_t>(angle.x) } << 32) | static_cast<std::uint32_t>(angle.y);
+}
+
+/** Asteroids that are the closest along their line of sight are visible, so each distinct angle counts once.
+ */
+int countDistinctAngles(std::vector<Line> const& lines, std::unordered_set<std::uint64_t>& scratch)
+{
+    scratch.clear();
+    for (auto const& l : lines) {
+        // don't count yourself
+        if (l.distance != 0) { scratch.insert(packAngle(l.angle)); }
+    }
+    return static_cast<int>(scratch.size());
+}
+}
+
+std::vector<Line> const& linesOfSightFrom(Map const& m, std::size_t origin, std::vector<Line>& scratch)
+{
+    assert(origin < m.asteroid_positions.size());
+    if (!m.lines_of_sight.empty()) {
+        assert(m.lines_of_sight.size() == m.asteroid_positions.size());
+        return m.lines_of_sight[origin];
+    }
+    scratch.clear();
+    for (auto const& target : m.asteroid_positions) { scratch.push_back(Line(m.asteroid_positions[origin], target)); }
+    return scratch;
 }
 
-std::tuple<int, std::size_t> bestVantagePoint(Map& m)
+int asteroidsVisibleFrom(Map const& m, std::size_t origin_index)
+{
+    std::vector<Line> scratch;
+    std::unordered_set<std::uint64_t> angles;
+    return countDistinctAngles(linesOfSightFrom(m, origin_index, scratch), angles);
+}
+
+std::tuple<int, std::size_t> bestVantagePoint(Map const& m)
 {
     int current_max = 0;
     std::size_t ret_index = m.asteroid_positions.size();
+    std::vector<Line> scratch;
+    std::unordered_set<std::uint64_t> angles;
     for (std::size_t i = 0; i < m.asteroid_positions.size(); ++i) {
-        int const visible = asteroidsVisibleFrom(m, i);
+        int const visible = countDistinctAngles(linesOfSightFrom(m, i, scratch), angles);
         if (visible > current_max) {
             current_max = visible;
             ret_index = i;
@@ -107,15 +131,45 @@ std::tuple<int, std::size_t> bestVantagePoint(Map& m)
     return std::make_tuple(current_max, ret_index);
 }
 
+std::vector<int> visibleCounts(Map const& m, unsigned n_threads)
+{
+    std::size_t const n = m.asteroid_positions.size();
+    std::vector<int> ret(n);
+    auto const count_range = [&m, &ret](std::size_t first, std::size_t last) {
+        // reusing one scratch buffer and set per thread keeps their memory allocated
+        std::vector<Line> scratch;
+        std::unordered_set<std::uint64_t> angles;
+        angles.reserve(m.asteroid_positions.size());
+        for (std::size_t i = first; i < last; ++i) { ret[i] = countDistinctAngles(linesOfSightFrom(m, i, scratch), angles); }
+    };
+    if (n_threads == 0) { n_threads = std::max(std::thread::hardware_concurrency(), 1u); }
+    std::size_t const slice = (n + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (std::size_t first = slice; first < n; first += slice) {
+        threads.emplace_back(count_range, first, std::min(first + slice, n));
+    }
+    count_range(0, std::min(slice, n));
+    for (auto& t : threads) { t.join(); }
+    return ret;
+}
+
+std::tuple<int, std::size_t> bestVantagePointParallel(Map const& m, unsigned n_threads)
+{
+    std::vector<int> const counts = visibleCounts(m, n_threads);
+    auto const it = std::max_element(begin(counts), end(counts));
+    if ((it == end(counts)) || (*it == 0)) { return std::make_tuple(0, m.asteroid_positions.size()); }
+    return std::make_tuple(*it, static_cast<std::size_t>(std::distance(begin(counts), it)));
+}
+
 int dot(Vector2 const& v1, Vector2 const& v2)
 {
     return (v1.x * v2.x) + (v1.y * v2.y);
 }
 
-std::vector<Target> determineTargets(Map& m, std::size_t origin)
+std::vector<Target> determineTargets(Map const& m, std::size_t origin)
 {
-    assert(origin < m.lines_of_sight.size());
-    std::vector<Line> const& targets = m.lines_of_sight[origin];
+    std::vector<Line> scratch;
+    std::vector<Line> const& targets = linesOfSightFrom(m, origin, scratch);
     std::vector<Target> ret;
     ret.reserve(targets.size() - 1);
     Vector2 const reference(0, -1);
@@ -28,16 +28,33 @@ struct Map {
     int width;
     int height;
     std::vector<Vector2> asteroid_positions;
-    std::vector<std::vector<Line>> lines_of_sight;
+    std::vector<std::vector<Line>> lines_of_sight;      ///< optional cache, empty unless determineLinesOfSight() was called
 };
 
 Map parseInput(std::string_view input);
 
+/** Fills the lines_of_sight cache for all asteroid pairs. This needs O(n^2) memory;
+ * without it, lines of sight are computed per origin as needed.
+ */
 void determineLinesOfSight(Map& m);
 
-int asteroidsVisibleFrom(Map& m, std::size_t origin_index);
+/** Lines of sight from origin to every asteroid, taken from the cache if present, otherwise computed into scratch.
+ */
+std::vector<Line> const& linesOfSightFrom(Map const& m, std::size_t origin, std::vector<Line>& scratch);
 
-std::tuple<int, std::size_t> bestVantagePoint(Map& m);
+int asteroidsVisibleFrom(Map const& m, std::size_t origin_index);
+
+std::tuple<int, std::size_t> bestVantagePoint(Map const& m);
+
+/** Number of asteroids visible from each asteroid.
+ * Counts the distinct directions from every origin with a hash set, in O(n^2) expected time overall.
+ * Origins are split evenly across n_threads threads; passing 0 uses the hardware concurrency.
+ */
+std::vector<int> visibleCounts(Map const& m, unsigned n_threads = 0);
+
+/** Same result as bestVantagePoint(), computed from visibleCounts().
+ */
+std::tuple<int, std::size_t> bestVantagePointParallel(Map const& m, unsigned n_threads = 0);
 
 int dot(Vector2 const& v1, Vector2 const& v2);
 
@@ -48,7 +65,7 @@ struct Target {
     float angle;
 };
 
-std::vector<Target> determineTargets(Map& m, std::size_t origin);
+std::vector<Target> determineTargets(Map const& m, std::size_t origin);
 
 std::vector<Vector2> vaporize(std::vector<Target> targets);
 
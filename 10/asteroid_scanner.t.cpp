@@ -2,6 +2,7 @@
 
 #include <catch.hpp>
 
+#include <tuple>
 #include <vector>
 
 TEST_CASE("Asteroid Scanner")
@@ -310,4 +311,81 @@ TEST_CASE("Asteroid Scanner")
             CHECK(vaporized.size() == 299);
         }
     }
+
+    SECTION("Parallel Vantage Point")
+    {
+        char const input[] = ".#..#..###\n"
+                             "####.###.#\n"
+                             "....###.#.\n"
+                             "..###.##.#\n"
+                             "##.##.#.#.\n"
+                             "....###..#\n"
+                             "..#.#..#.#\n"
+                             "#..#.#.###\n"
+                             ".##...##.#\n"
+                             ".....#.#..\n";
+        for (char const* map_input : { sample_input, input }) {
+            Map m = parseInput(map_input);
+            determineLinesOfSight(m);
+            std::vector<int> expected;
+            for (std::size_t i = 0; i < m.asteroid_positions.size(); ++i) { expected.push_back(asteroidsVisibleFrom(m, i)); }
+            for (unsigned n_threads : { 1, 3, 0 }) {
+                CHECK(visibleCounts(m, n_threads) == expected);
+                CHECK(bestVantagePointParallel(m, n_threads) == bestVantagePoint(m));
+            }
+        }
+        Map empty = parseInput(".#.\n...\n");
+        determineLinesOfSight(empty);
+        CHECK(bestVantagePointParallel(empty) == std::make_tuple(0, std::size_t{ 1 }));
+    }
+
+    SECTION("Lazy Lines of Sight")
+    {
+        char const input[] = ".#..##.###...#######\n"
+                             "##.############..##.\n"
+                             ".#.######.########.#\n"
+                             ".###.#######.####.#.\n"
+                             "#####.##.#.##.###.##\n"
+                             "..#####..#.#########\n"
+                             "####################\n"
+                             "#.####....###.#.#.##\n"
+                             "##.#################\n"
+                             "#####.##.###..####..\n"
+                             "..######..##.#######\n"
+                             "####.##.####...##..#\n"
+                             ".#####..#.######.###\n"
+                             "##...#.##########...\n"
+                             "#.##########.#######\n"
+                             ".####.#.###.###.#.##\n"
+                             "....##.##.###..#####\n"
+                             ".#.#.###########.###\n"
+                             "#.#.#.#####.####.###\n"
+                             "###.##.####.##.#..##\n";
+        Map const lazy = parseInput(input);
+        Map cached = parseInput(input);
+        determineLinesOfSight(cached);
+        CHECK(lazy.lines_of_sight.empty());
+
+        std::vector<Line> scratch;
+        for (std::size_t i : { std::size_t{ 0 }, std::size_t{ 17 }, lazy.asteroid_positions.size() - 1 }) {
+            auto const& lazy_lines = linesOfSightFrom(lazy, i, scratch);
+            CHECK(&lazy_lines == &scratch);
+            auto const& cached_lines = linesOfSightFrom(cached, i, scratch);
+            CHECK(&cached_lines == &cached.lines_of_sight[i]);
+            REQUIRE(lazy_lines.size() == cached_lines.size());
+            for (std::size_t j = 0; j < lazy_lines.size(); ++j) {
+                CHECK(scratch[j].angle == cached.lines_of_sight[i][j].angle);
+                CHECK(scratch[j].distance == cached.lines_of_sight[i][j].distance);
+            }
+            CHECK(asteroidsVisibleFrom(lazy, i) == asteroidsVisibleFrom(cached, i));
+        }
+        CHECK(visibleCounts(lazy, 4) == visibleCounts(cached, 4));
+        auto const [visible, index] = bestVantagePoint(lazy);
+        CHECK(visible == 210);
+        CHECK(lazy.asteroid_positions[index] == Vector2(11, 13));
+        CHECK(bestVantagePointParallel(lazy, 3) == bestVantagePoint(cached));
+        auto const vaporized = vaporize(determineTargets(lazy, index));
+        CHECK(vaporized == vaporize(determineTargets(cached, index)));
+        CHECK(vaporized[199] == Vector2(8, 2));
+    }
 }
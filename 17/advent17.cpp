@@ -24,7 +24,8 @@ std::optional<std::string> readInput(char const* filename)
     return sstr.str();
 }
 
-void printOutput(Intcode& p, std::ostream& os = std::cout)
+template<typename Intcode_T>
+void printOutput(Intcode_T& p, std::ostream& os = std::cout)
 {
     for (auto const& c : p.output()) {
         os << static_cast<char>(c);
@@ -48,7 +49,7 @@ int main(int argc, char* argv[])
     bool const do_output = false;
 
     auto iprog = parseInput(*input);
-    Intcode p(iprog);
+    StaticIntcode p(iprog);
     p.execute();
     Map m = parseMap(p.output());
     markIntersections(m);
@@ -69,7 +70,7 @@ int main(int argc, char* argv[])
     assert(moveC.size() <= 20);
     iprog.memory[0] = 2;
 
-    Intcode p2(iprog);
+    StaticIntcode p2(iprog);
     p2.execute();
     if constexpr (do_output) { printOutput(p2); }
     if (p2.pc() != ResultCode::MissingInput) { return 1; }
@@ -25,7 +25,7 @@ Tile::Tile()
     :isIntersection(false)
 {}
 
-Map parseMap(std::vector<Word> const& intcode_output)
+Map parseMap(std::span<Word const> intcode_output)
 {
     Map ret;
     ret.map_width = -1;
@@ -3,6 +3,7 @@
 
 #include <intcode.hpp>
 
+#include <span>
 #include <string_view>
 #include <iosfwd>
 
@@ -57,7 +58,7 @@ struct Map {
     std::unordered_map<Vector2, Tile> map;
 };
 
-Map parseMap(std::vector<Word> const& intcode_output);
+Map parseMap(std::span<Word const> intcode_output);
 
 void markIntersections(Map& m);
 
@@ -10,6 +10,7 @@
 #include <range/v3/range/conversion.hpp>
 #include <range/v3/range/operations.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <string>
@@ -26,106 +27,110 @@ IntcodeProgram parseInput(std::string_view input)
     return IntcodeProgram{ std::move(memory), 0, 0, {}, {}, 0 };
 }
 
-std::tuple<Opcode, Mode, Mode, Mode> decode(Word instruction)
-{
-    auto const opcode = static_cast<Opcode>(instruction % 100);
-    int const arity = [opcode]() {
-        switch (opcode)
-        {
-        case Opcode::Add: return 3;
-        case Opcode::Multiply: return 3;
-        case Opcode::Input: return 1;
-        case Opcode::Output: return 1;
-        case Opcode::JumpIfTrue: return 2;
-        case Opcode::JumpIfFalse: return 2;
-        case Opcode::LessThan: return 3;
-        case Opcode::Equals: return 3;
-        case Opcode::AdjustRelativeBase: return 1;
-        case Opcode::Halt: return 0;
-        default: return -1;
-        }
-    }();
-    auto const mode_1 = (arity >= 1) ? static_cast<Mode>((instruction / 100) % 10) : Mode::NoArgument;
-    auto const mode_2 = (arity >= 2) ? static_cast<Mode>((instruction / 1000) % 10) : Mode::NoArgument;
-    auto const mode_3 = (arity >= 3) ? static_cast<Mode>((instruction / 10000) % 10) : Mode::NoArgument;
-    assert((mode_1 == Mode::Position) || (mode_1 == Mode::Immediate) || (mode_1 == Mode::Relative) || (mode_1 == Mode::NoArgument));
-    assert((mode_2 == Mode::Position) || (mode_2 == Mode::Immediate) || (mode_2 == Mode::Relative) || (mode_2 == Mode::NoArgument));
-    assert((mode_3 == Mode::Position) || (mode_3 == Mode::Immediate) || (mode_3 == Mode::Relative) || (mode_3 == Mode::NoArgument));
-    return std::make_tuple(opcode, mode_1, mode_2, mode_3);
-}
-
 void executeOpcode(IntcodeProgram& p)
 {
-    auto fetch_arg = [&p](Address position, Mode mode) -> Word& {
-        if (mode == Mode::Position) {
-            assert(p.memory[p.pc + position] >= 0);
-            return (p.memory[p.memory[p.pc + position]]);
-        } else if (mode == Mode::Immediate) {
-            return (p.memory[p.pc + position]);
-        } else {
-            assert(mode == Mode::Relative);
-            assert(p.memory[p.pc + position] + p.base >= 0);
-            return (p.memory[p.memory[p.pc + position] + p.base]);
-        }
-    };
-    auto const [opcode, mode_1, mode_2, mode_3] = decode(p.memory[p.pc]);
-    switch (opcode) {
-    case Opcode::Add:
-        fetch_arg(3, mode_3) = fetch_arg(1, mode_1) + fetch_arg(2, mode_2);
-        p.pc += 4;
-        break;
-    case Opcode::Multiply:
-        fetch_arg(3, mode_3) = fetch_arg(1, mode_1) * fetch_arg(2, mode_2);
-        p.pc += 4;
-        break;
-    case Opcode::Input:
-        if (p.input.empty()) { p.resume_point = p.pc; p.pc = ResultCode::MissingInput; break; }
-        fetch_arg(1, mode_1) = p.input.front();
-        p.input.erase(p.input.begin());
-        p.pc += 2;
-        break;
-    case Opcode::Output:
-        p.output.push_back(fetch_arg(1, mode_1));
-        p.pc += 2;
-        break;
-    case Opcode::JumpIfTrue:
-        if (fetch_arg(1, mode_1) != 0) {
-            p.pc = fetch_arg(2, mode_2);
-        } else {
-            p.pc += 3;
-        }
-        break;
-    case Opcode::JumpIfFalse:
-        if (fetch_arg(1, mode_1) == 0) {
-            p.pc = fetch_arg(2, mode_2);
-        } else {
-            p.pc += 3;
-        }
-        break;
-    case Opcode::LessThan:
-        fetch_arg(3, mode_3) = (fetch_arg(1, mode_1) < fetch_arg(2, mode_2)) ? 1 : 0;
-        p.pc += 4;
-        break;
-    case Opcode::Equals:
-        fetch_arg(3, mode_3) = (fetch_arg(1, mode_1) == fetch_arg(2, mode_2)) ? 1 : 0;
-        p.pc += 4;
-        break;
-    case Opcode::AdjustRelativeBase:
-        p.base += fetch_arg(1, mode_1);
-        p.pc += 2;
-        break;
-    case Opcode::Halt:
-        p.pc = ResultCode::Halted;
-        break;
-    default:
-        p.pc = ResultCode::InvalidOpcode;
-        break;
-    }
+    executeOpcode_impl(p);
 }
 
 void executeProgram(IntcodeProgram& p)
 {
-    while (p.pc >= 0) {
-        executeOpcode(p);
+    executeProgram_impl(p);
+}
+
+PooledIntcodeProgram::PooledIntcodeProgram(std::pmr::memory_resource* resource)
+    :memory(resource), pc(0), base(0), input(resource), output(resource), resume_point(0)
+{}
+
+void executeOpcode(PooledIntcodeProgram& p)
+{
+    executeOpcode_impl(p);
+}
+
+void executeProgram(PooledIntcodeProgram& p)
+{
+    executeProgram_impl(p);
+}
+
+void reset(PooledIntcodeProgram& p, IntcodeProgram const& image)
+{
+    // clear() hands the nodes back to the pool but keeps the bucket array around
+    p.memory.clear();
+    p.memory.insert(image.memory.begin(), image.memory.end());
+    p.pc = image.pc;
+    p.base = image.base;
+    p.input.assign(image.input.begin(), image.input.end());
+    p.output.assign(image.output.begin(), image.output.end());
+    p.resume_point = image.resume_point;
+}
+
+IntcodePool::CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    :m_upstream(upstream), m_allocationCount(0)
+{}
+
+std::size_t IntcodePool::CountingResource::allocationCount() const
+{
+    return m_allocationCount;
+}
+
+void* IntcodePool::CountingResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    ++m_allocationCount;
+    return m_upstream->allocate(bytes, alignment);
+}
+
+void IntcodePool::CountingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+    m_upstream->deallocate(p, bytes, alignment);
+}
+
+bool IntcodePool::CountingResource::do_is_equal(std::pmr::memory_resource const& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+IntcodePool::IntcodePool()
+    :m_upstream(std::pmr::new_delete_resource()), m_resource(&m_upstream)
+{}
+
+IntcodePool::Handle IntcodePool::acquire(IntcodeProgram const& image)
+{
+    Handle h;
+    if (m_freeList.empty()) {
+        h = m_programs.size();
+        m_programs.emplace_back(&m_resource);
+    } else {
+        h = m_freeList.back();
+        m_freeList.pop_back();
     }
+    reset(m_programs[h], image);
+    return h;
+}
+
+void IntcodePool::release(Handle h)
+{
+    assert(h < m_programs.size());
+    assert(std::find(m_freeList.begin(), m_freeList.end(), h) == m_freeList.end());
+    m_freeList.push_back(h);
+}
+
+PooledIntcodeProgram& IntcodePool::operator[](Handle h)
+{
+    assert(h < m_programs.size());
+    return m_programs[h];
+}
+
+PooledIntcodeProgram const& IntcodePool::operator[](Handle h) const
+{
+    assert(h < m_programs.size());
+    return m_programs[h];
+}
+
+std::size_t IntcodePool::capacity() const
+{
+    return m_programs.size();
+}
+
+std::size_t IntcodePool::allocationCount() const
+{
+    return m_upstream.allocationCount();
 }
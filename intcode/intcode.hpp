@@ -1,10 +1,22 @@
 #ifndef ADVENT_OF_CODE_INTCODE_HPP_INCLUDE_GUARD
 #define ADVENT_OF_CODE_INTCODE_HPP_INCLUDE_GUARD
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
 using Word = int64_t;
@@ -50,12 +62,196 @@ struct ResultCode {
 
 IntcodeProgram parseInput(std::string_view input);
 
-std::tuple<Opcode, Mode, Mode, Mode> decode(Word instruction);
+constexpr std::tuple<Opcode, Mode, Mode, Mode> decode(Word instruction)
+{
+    auto const opcode = static_cast<Opcode>(instruction % 100);
+    int const arity = [opcode]() {
+        switch (opcode)
+        {
+        case Opcode::Add: return 3;
+        case Opcode::Multiply: return 3;
+        case Opcode::Input: return 1;
+        case Opcode::Output: return 1;
+        case Opcode::JumpIfTrue: return 2;
+        case Opcode::JumpIfFalse: return 2;
+        case Opcode::LessThan: return 3;
+        case Opcode::Equals: return 3;
+        case Opcode::AdjustRelativeBase: return 1;
+        case Opcode::Halt: return 0;
+        default: return -1;
+        }
+    }();
+    auto const mode_1 = (arity >= 1) ? static_cast<Mode>((instruction / 100) % 10) : Mode::NoArgument;
+    auto const mode_2 = (arity >= 2) ? static_cast<Mode>((instruction / 1000) % 10) : Mode::NoArgument;
+    auto const mode_3 = (arity >= 3) ? static_cast<Mode>((instruction / 10000) % 10) : Mode::NoArgument;
+    assert((mode_1 == Mode::Position) || (mode_1 == Mode::Immediate) || (mode_1 == Mode::Relative) || (mode_1 == Mode::NoArgument));
+    assert((mode_2 == Mode::Position) || (mode_2 == Mode::Immediate) || (mode_2 == Mode::Relative) || (mode_2 == Mode::NoArgument));
+    assert((mode_3 == Mode::Position) || (mode_3 == Mode::Immediate) || (mode_3 == Mode::Relative) || (mode_3 == Mode::NoArgument));
+    return std::make_tuple(opcode, mode_1, mode_2, mode_3);
+}
 
 void executeOpcode(IntcodeProgram& p);
 
 void executeProgram(IntcodeProgram& p);
 
+template<typename Container_T>
+constexpr void dropFirstInput(Container_T& input)
+{
+    input.erase(input.begin());
+}
+
+constexpr void dropFirstInput(std::span<Word const>& input)
+{
+    input = input.subspan(1);
+}
+
+/** Interpreter shared by all program representations.
+ * IntcodeProgram_T needs to provide the members of IntcodeProgram, with memory indexable by Address.
+ */
+template<typename IntcodeProgram_T>
+constexpr void executeOpcode_impl(IntcodeProgram_T& p)
+{
+    auto fetch_arg = [&p](Address position, Mode mode) -> Word& {
+        if (mode == Mode::Position) {
+            assert(p.memory[p.pc + position] >= 0);
+            return (p.memory[p.memory[p.pc + position]]);
+        } else if (mode == Mode::Immediate) {
+            return (p.memory[p.pc + position]);
+        } else {
+            assert(mode == Mode::Relative);
+            assert(p.memory[p.pc + position] + p.base >= 0);
+            return (p.memory[p.memory[p.pc + position] + p.base]);
+        }
+    };
+    auto const [opcode, mode_1, mode_2, mode_3] = decode(p.memory[p.pc]);
+    switch (opcode) {
+    case Opcode::Add:
+        fetch_arg(3, mode_3) = fetch_arg(1, mode_1) + fetch_arg(2, mode_2);
+        p.pc += 4;
+        break;
+    case Opcode::Multiply:
+        fetch_arg(3, mode_3) = fetch_arg(1, mode_1) * fetch_arg(2, mode_2);
+        p.pc += 4;
+        break;
+    case Opcode::Input:
+        if (p.input.empty()) { p.resume_point = p.pc; p.pc = ResultCode::MissingInput; break; }
+        fetch_arg(1, mode_1) = p.input.front();
+        dropFirstInput(p.input);
+        p.pc += 2;
+        break;
+    case Opcode::Output:
+        p.output.push_back(fetch_arg(1, mode_1));
+        p.pc += 2;
+        break;
+    case Opcode::JumpIfTrue:
+        if (fetch_arg(1, mode_1) != 0) {
+            p.pc = fetch_arg(2, mode_2);
+        } else {
+            p.pc += 3;
+        }
+        break;
+    case Opcode::JumpIfFalse:
+        if (fetch_arg(1, mode_1) == 0) {
+            p.pc = fetch_arg(2, mode_2);
+        } else {
+            p.pc += 3;
+        }
+        break;
+    case Opcode::LessThan:
+        fetch_arg(3, mode_3) = (fetch_arg(1, mode_1) < fetch_arg(2, mode_2)) ? 1 : 0;
+        p.pc += 4;
+        break;
+    case Opcode::Equals:
+        fetch_arg(3, mode_3) = (fetch_arg(1, mode_1) == fetch_arg(2, mode_2)) ? 1 : 0;
+        p.pc += 4;
+        break;
+    case Opcode::AdjustRelativeBase:
+        p.base += fetch_arg(1, mode_1);
+        p.pc += 2;
+        break;
+    case Opcode::Halt:
+        p.pc = ResultCode::Halted;
+        break;
+    default:
+        p.pc = ResultCode::InvalidOpcode;
+        break;
+    }
+}
+
+template<typename IntcodeProgram_T>
+constexpr void executeProgram_impl(IntcodeProgram_T& p)
+{
+    while (p.pc >= 0) {
+        executeOpcode_impl(p);
+    }
+}
+
+/** Program state whose containers draw their memory from an IntcodePool.
+ */
+struct PooledIntcodeProgram {
+    std::pmr::unordered_map<Address, Word> memory;
+    Address pc;
+    Address base;
+    std::pmr::vector<Word> input;
+    std::pmr::vector<Word> output;
+    Address resume_point;
+
+    explicit PooledIntcodeProgram(std::pmr::memory_resource* resource);
+};
+
+void executeOpcode(PooledIntcodeProgram& p);
+
+void executeProgram(PooledIntcodeProgram& p);
+
+/** Restores p to the state of image, keeping all memory already owned by p.
+ */
+void reset(PooledIntcodeProgram& p, IntcodeProgram const& image);
+
+/** Reusable arena of Intcode machines.
+ * Released machines keep their memory, which is handed out again on the next acquire,
+ * so repeatedly running the same program does not touch the heap once warmed up.
+ * The pool is not thread-safe.
+ */
+class IntcodePool {
+public:
+    using Handle = std::size_t;
+private:
+    class CountingResource : public std::pmr::memory_resource {
+    private:
+        std::pmr::memory_resource* m_upstream;
+        std::size_t m_allocationCount;
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream);
+        std::size_t allocationCount() const;
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(std::pmr::memory_resource const& rhs) const noexcept override;
+    };
+
+    CountingResource m_upstream;
+    std::pmr::unsynchronized_pool_resource m_resource;
+    std::deque<PooledIntcodeProgram> m_programs;
+    std::vector<Handle> m_freeList;
+public:
+    IntcodePool();
+    IntcodePool(IntcodePool const&) = delete;
+    IntcodePool& operator=(IntcodePool const&) = delete;
+
+    Handle acquire(IntcodeProgram const& image);
+    void release(Handle h);
+
+    PooledIntcodeProgram& operator[](Handle h);
+    PooledIntcodeProgram const& operator[](Handle h) const;
+
+    /** Number of machines ever created by the pool, whether in use or released.
+     */
+    std::size_t capacity() const;
+    /** Number of allocations the pool requested from the global heap.
+     */
+    std::size_t allocationCount() const;
+};
+
 class Intcode {
 public:
     struct Concept {
@@ -148,4 +344,253 @@ inline std::unique_ptr<Intcode::Concept> makeConceptHandle(IntcodeProgram_T cons
     return std::make_unique<IntcodeProgramModel<IntcodeProgram_T>>(p);
 }
 
+/** Read-only view of an Intcode input or output buffer.
+ */
+class WordBufferView {
+private:
+    std::span<Word const> m_words;
+public:
+    WordBufferView(std::span<Word const> words) :m_words(words) {}
+
+    bool empty() const { return m_words.empty(); }
+    std::size_t size() const { return m_words.size(); }
+    Word const* data() const { return m_words.data(); }
+    Word const* begin() const { return data(); }
+    Word const* end() const { return data() + size(); }
+    Word const& operator[](std::size_t i) const { assert(i < size()); return m_words[i]; }
+    Word const& front() const { assert(!empty()); return m_words.front(); }
+    Word const& back() const { assert(!empty()); return m_words.back(); }
+
+    friend bool operator==(WordBufferView const& lhs, std::span<Word const> rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+};
+
+/** Mutable view of an Intcode input or output buffer, independent of the container type the engine uses.
+ * Offers the subset of std::vector operations needed to feed and drain a program.
+ */
+class WordBufferRef {
+private:
+    std::variant<std::vector<Word>*, std::pmr::vector<Word>*> m_buffer;
+
+    template<typename Func_T>
+    decltype(auto) visit(Func_T&& f) const {
+        return std::visit([&f](auto* b) -> decltype(auto) { return f(*b); }, m_buffer);
+    }
+public:
+    WordBufferRef(std::vector<Word>& b) :m_buffer(&b) {}
+    WordBufferRef(std::pmr::vector<Word>& b) :m_buffer(&b) {}
+
+    bool empty() const { return visit([](auto& b) { return b.empty(); }); }
+    std::size_t size() const { return visit([](auto& b) { return b.size(); }); }
+    Word* data() const { return visit([](auto& b) { return b.data(); }); }
+    Word* begin() const { return data(); }
+    Word* end() const { return data() + size(); }
+    Word& operator[](std::size_t i) const { assert(i < size()); return data()[i]; }
+    Word& front() const { assert(!empty()); return data()[0]; }
+    Word& back() const { assert(!empty()); return data()[size() - 1]; }
+    void push_back(Word w) const { visit([w](auto& b) { b.push_back(w); }); }
+    void pop_back() const { visit([](auto& b) { b.pop_back(); }); }
+    void clear() const { visit([](auto& b) { b.clear(); }); }
+    template<typename Iterator_T>
+    void insert(Word const* pos, Iterator_T first, Iterator_T last) const {
+        std::ptrdiff_t const offset = pos - data();
+        visit([offset, first, last](auto& b) { b.insert(b.begin() + offset, first, last); });
+    }
+
+    friend bool operator==(WordBufferRef const& lhs, std::span<Word const> rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+};
+
+/** Statically dispatched counterpart to Intcode.
+ * Offers the same interface, but stores the program by value in a variant over a closed set of
+ * engine types, so accessors can be inlined. Use Intcode for engines not known up front.
+ * Pooled engines are held as std::reference_wrapper, so they keep drawing memory from their pool;
+ * copies of the variant then refer to the same engine.
+ * If all engines store input and output in the same container type, input() and output() return
+ * that container; otherwise they return a WordBufferRef, or a WordBufferView for const access.
+ */
+template<typename... IntcodeProgram_Ts>
+class IntcodeVariant {
+private:
+    static_assert((!std::is_same_v<IntcodeProgram_Ts, PooledIntcodeProgram> && ...),
+                  "Copying a PooledIntcodeProgram detaches it from its pool; use std::reference_wrapper instead");
+
+    std::variant<IntcodeProgram_Ts...> m_program;
+
+    template<typename T>
+    using ProgramOf = std::remove_reference_t<std::unwrap_reference_t<T>>;
+
+    using FirstProgram = ProgramOf<std::tuple_element_t<0, std::tuple<IntcodeProgram_Ts...>>>;
+    using Buffer = decltype(FirstProgram::input);
+    static constexpr bool has_uniform_buffers =
+        ((std::is_same_v<decltype(ProgramOf<IntcodeProgram_Ts>::input), Buffer> &&
+          std::is_same_v<decltype(ProgramOf<IntcodeProgram_Ts>::output), Buffer>) && ...);
+
+    /** Access to the engine stored in an alternative, looking through std::reference_wrapper.
+     */
+    template<typename T>
+    static decltype(auto) program(T& p) {
+        using Alternative = std::remove_const_t<T>;
+        if constexpr (std::is_same_v<std::unwrap_reference_t<Alternative>, Alternative>) {
+            return (p);
+        } else if constexpr (std::is_const_v<T>) {
+            return std::as_const(p.get());
+        } else {
+            return p.get();
+        }
+    }
+
+    template<typename Member_T>
+    decltype(auto) buffer(Member_T member) {
+        if constexpr (has_uniform_buffers) {
+            return std::visit([member](auto& p) -> Buffer& { return *member(program(p)); }, m_program);
+        } else {
+            return std::visit([member](auto& p) { return WordBufferRef(*member(program(p))); }, m_program);
+        }
+    }
+    template<typename Member_T>
+    decltype(auto) buffer(Member_T member) const {
+        if constexpr (has_uniform_buffers) {
+            return std::visit([member](auto const& p) -> Buffer const& { return *member(program(p)); }, m_program);
+        } else {
+            return std::visit([member](auto const& p) { return WordBufferView(*member(program(p))); }, m_program);
+        }
+    }
+    static constexpr auto input_of = [](auto& p) { return &p.input; };
+    static constexpr auto output_of = [](auto& p) { return &p.output; };
+public:
+    template<typename T> requires (std::is_same_v<T, IntcodeProgram_Ts> || ...)
+    explicit IntcodeVariant(T const& v)
+        :m_program(v)
+    {}
+
+    ResultCode::ResultCodes execute() {
+        return std::visit([](auto& p) {
+                auto& prog = program(p);
+                executeProgram(prog);
+                return static_cast<ResultCode::ResultCodes>(prog.pc);
+            }, m_program);
+    }
+    ResultCode::ResultCodes resumeExecution() {
+        std::visit([](auto& p) { auto& prog = program(p); prog.pc = prog.resume_point; }, m_program);
+        return execute();
+    }
+    Address& pc() { return std::visit([](auto& p) -> Address& { return program(p).pc; }, m_program); }
+    Address const& pc() const {
+        return std::visit([](auto const& p) -> Address const& { return program(p).pc; }, m_program);
+    }
+    decltype(auto) input() { return buffer(input_of); }
+    decltype(auto) input() const { return buffer(input_of); }
+    decltype(auto) output() { return buffer(output_of); }
+    decltype(auto) output() const { return buffer(output_of); }
+};
+
+using StaticIntcode = IntcodeVariant<IntcodeProgram>;
+
+/** Variant over plain and pooled engines. The buffers differ in type, so accessors go through WordBufferRef.
+ */
+using MixedIntcode = IntcodeVariant<IntcodeProgram, std::reference_wrapper<PooledIntcodeProgram>>;
+
+
+/** Vector with a fixed capacity that can be used in constant expressions.
+ */
+template<typename T, std::size_t N>
+class FixedCapacityVector {
+private:
+    std::array<T, N> m_data{};
+    std::size_t m_size = 0;
+public:
+    constexpr bool empty() const { return m_size == 0; }
+    constexpr std::size_t size() const { return m_size; }
+    static constexpr std::size_t capacity() { return N; }
+    constexpr void clear() { m_size = 0; }
+    constexpr void push_back(T const& v) { assert(m_size < N); m_data[m_size++] = v; }
+    constexpr void pop_back() { assert(m_size > 0); --m_size; }
+    constexpr T& back() { assert(m_size > 0); return m_data[m_size - 1]; }
+    constexpr T const& back() const { assert(m_size > 0); return m_data[m_size - 1]; }
+    constexpr T& operator[](std::size_t i) { assert(i < m_size); return m_data[i]; }
+    constexpr T const& operator[](std::size_t i) const { assert(i < m_size); return m_data[i]; }
+    constexpr T* begin() { return m_data.data(); }
+    constexpr T* end() { return m_data.data() + m_size; }
+    constexpr T const* begin() const { return m_data.data(); }
+    constexpr T const* end() const { return m_data.data() + m_size; }
+};
+
+/** Program state for running Intcode in constant expressions.
+ * Memory is fixed at MemorySize words and programs must not address memory beyond that.
+ * Input is consumed from the front of the input span.
+ */
+template<std::size_t MemorySize, std::size_t OutputCapacity>
+struct ConstexprIntcodeProgram {
+    std::array<Word, MemorySize> memory;
+    Address pc;
+    Address base;
+    std::span<Word const> input;
+    FixedCapacityVector<Word, OutputCapacity> output;
+    Address resume_point;
+};
+
+template<std::size_t MemorySize, std::size_t OutputCapacity>
+constexpr void executeOpcode(ConstexprIntcodeProgram<MemorySize, OutputCapacity>& p)
+{
+    executeOpcode_impl(p);
+}
+
+template<std::size_t MemorySize, std::size_t OutputCapacity>
+constexpr void executeProgram(ConstexprIntcodeProgram<MemorySize, OutputCapacity>& p)
+{
+    executeProgram_impl(p);
+}
+
+/** Parses a program into a memory image of MemorySize words. Memory past the end of the program is zero.
+ */
+template<std::size_t MemorySize>
+constexpr std::array<Word, MemorySize> parseConstexprMemory(std::string_view input)
+{
+    std::array<Word, MemorySize> ret{};
+    std::size_t index = 0;
+    Word value = 0;
+    bool is_negative = false;
+    bool has_digits = false;
+    for (char const c : input) {
+        if (c == '-') {
+            assert(!has_digits && !is_negative);
+            is_negative = true;
+        } else if ((c >= '0') && (c <= '9')) {
+            value = value * 10 + (c - '0');
+            has_digits = true;
+        } else if ((c == ',') || (c == '\n')) {
+            if (has_digits) {
+                assert(index < MemorySize);
+                ret[index++] = is_negative ? -value : value;
+            }
+            value = 0;
+            is_negative = false;
+            has_digits = false;
+        } else {
+            assert(c == ' ');
+        }
+    }
+    if (has_digits) {
+        assert(index < MemorySize);
+        ret[index] = is_negative ? -value : value;
+    }
+    return ret;
+}
+
+/** Runs the program in memory until it halts or blocks on input.
+ * The returned program no longer refers to input.
+ */
+template<std::size_t OutputCapacity, std::size_t MemorySize>
+constexpr ConstexprIntcodeProgram<MemorySize, OutputCapacity> evaluateProgram(std::array<Word, MemorySize> const& memory,
+                                                                              std::span<Word const> input = {})
+{
+    ConstexprIntcodeProgram<MemorySize, OutputCapacity> p{ memory, 0, 0, input, {}, 0 };
+    executeProgram(p);
+    p.input = {};
+    return p;
+}
+
 #endif
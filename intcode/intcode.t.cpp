@@ -2,6 +2,11 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -516,5 +521,159 @@ TEST_CASE("Integer Program")
             CHECK(p.output == std::vector<Word>{ 1125899906842624 });
         }
     }
+
+    SECTION("Static Dispatch")
+    {
+        auto const iprog = parseInput("3,0,4,0,3,0,4,0,99");
+        StaticIntcode p(iprog);
+        Intcode p_erased(iprog);
+        CHECK(p.execute() == ResultCode::MissingInput);
+        CHECK(p_erased.execute() == ResultCode::MissingInput);
+        CHECK(p.pc() == p_erased.pc());
+
+        p.input().push_back(42);
+        p_erased.input().push_back(42);
+        CHECK(p.resumeExecution() == ResultCode::MissingInput);
+        CHECK(p_erased.resumeExecution() == ResultCode::MissingInput);
+        CHECK(p.input().empty());
+        CHECK(p.output() == std::vector<Word>{ 42 });
+        CHECK(p.output() == p_erased.output());
+
+        StaticIntcode p_copy = p;
+        p.input().push_back(23);
+        CHECK(p.resumeExecution() == ResultCode::Halted);
+        CHECK(p.output() == std::vector<Word>{ 42, 23 });
+        CHECK(p_copy.pc() == ResultCode::MissingInput);
+        CHECK(p_copy.output() == std::vector<Word>{ 42 });
+
+        StaticIntcode const& p_const = p;
+        CHECK(p_const.pc() == ResultCode::Halted);
+        CHECK(p_const.input().empty());
+        CHECK(p_const.output() == std::vector<Word>{ 42, 23 });
+
+        static_assert(!std::is_convertible_v<IntcodeProgram, StaticIntcode>);
+    }
+
+    SECTION("Static Dispatch Pooled")
+    {
+        static_assert(std::is_same_v<decltype(std::declval<StaticIntcode&>().output()), std::vector<Word>&>);
+        auto const iprog = parseInput("3,0,4,0,3,0,4,0,99");
+        IntcodePool pool;
+        // warm up the pool, so that running again must not allocate
+        auto h = pool.acquire(iprog);
+        pool[h].input.assign({ 1, 2 });
+        executeProgram(pool[h]);
+        pool.release(h);
+        h = pool.acquire(iprog);
+        auto const allocations = pool.allocationCount();
+
+        MixedIntcode p(std::ref(pool[h]));
+        CHECK(p.execute() == ResultCode::MissingInput);
+        CHECK(p.input().empty());
+
+        std::vector<Word> const words{ 42, 23 };
+        p.input().insert(p.input().end(), words.begin(), words.end());
+        CHECK(p.input().size() == 2);
+        CHECK(p.resumeExecution() == ResultCode::Halted);
+        CHECK(p.output() == std::vector<Word>{ 42, 23 });
+        CHECK(p.output().data() == pool[h].output.data());
+        CHECK(p.output().back() == 23);
+        p.output().pop_back();
+        CHECK(pool[h].output.size() == 1);
+
+        MixedIntcode const& p_const = p;
+        CHECK(p_const.input().empty());
+        CHECK(p_const.output() == std::vector<Word>{ 42 });
+        p.output().clear();
+        CHECK(p_const.output().empty());
+        CHECK(pool.allocationCount() == allocations);
+
+        MixedIntcode p_plain(iprog);
+        CHECK(p_plain.execute() == ResultCode::MissingInput);
+        p_plain.input().push_back(5);
+        CHECK(p_plain.resumeExecution() == ResultCode::MissingInput);
+        CHECK(p_plain.output() == std::vector<Word>{ 5 });
+    }
+
+    SECTION("Program Pool")
+    {
+        auto const iprog = parseInput("3,0,4,0,3,0,4,0,99");
+        IntcodePool pool;
+        CHECK(pool.capacity() == 0);
+        auto const h1 = pool.acquire(iprog);
+        auto const h2 = pool.acquire(iprog);
+        CHECK(h1 != h2);
+        CHECK(pool.capacity() == 2);
+
+        pool[h1].input.push_back(42);
+        pool[h1].input.push_back(23);
+        executeProgram(pool[h1]);
+        CHECK(pool[h1].pc == ResultCode::Halted);
+        CHECK(pool[h1].output == std::pmr::vector<Word>{ 42, 23 });
+        CHECK(pool[h1].memory[0] == 23);
+        CHECK(pool[h2].pc == 0);
+        CHECK(pool[h2].memory[0] == 3);
+
+        pool.release(h1);
+        auto const h3 = pool.acquire(iprog);
+        CHECK(h3 == h1);
+        CHECK(pool.capacity() == 2);
+        CHECK(pool[h3].pc == 0);
+        CHECK(pool[h3].memory.size() == iprog.memory.size());
+        CHECK(pool[h3].memory[0] == 3);
+        CHECK(pool[h3].output.empty());
+
+        auto const run = [&pool, &iprog]() {
+            auto const h = pool.acquire(iprog);
+            pool[h].input.push_back(1);
+            pool[h].input.push_back(2);
+            executeProgram(pool[h]);
+            CHECK(pool[h].output == std::pmr::vector<Word>{ 1, 2 });
+            pool.release(h);
+        };
+        pool.release(h2);
+        pool.release(h3);
+        run();
+        auto const warm_allocations = pool.allocationCount();
+        CHECK(warm_allocations > 0);
+        for (int i = 0; i < 10; ++i) { run(); }
+        CHECK(pool.allocationCount() == warm_allocations);
+    }
+
+    SECTION("Constexpr Evaluation")
+    {
+        static_assert(decode(1101) == std::make_tuple(Opcode::Add, Mode::Immediate, Mode::Immediate, Mode::Position));
+        static_assert(parseConstexprMemory<6>("1,-2,3\n") == std::array<Word, 6>{ 1, -2, 3, 0, 0, 0 });
+
+        constexpr auto p1 = evaluateProgram<1>(parseConstexprMemory<12>("1,9,10,3,2,3,11,0,99,30,40,50"));
+        static_assert(p1.pc == ResultCode::Halted);
+        static_assert(p1.memory[0] == 3500);
+        static_assert(p1.output.empty());
+
+        constexpr auto memory_equals = parseConstexprMemory<11>("3,9,8,9,10,9,4,9,99,-1,8");
+        static_assert(evaluateProgram<1>(memory_equals, std::array<Word, 1>{ 7 }).output[0] == 0);
+        static_assert(evaluateProgram<1>(memory_equals, std::array<Word, 1>{ 8 }).output[0] == 1);
+        static_assert(evaluateProgram<1>(memory_equals).pc == ResultCode::MissingInput);
+        static_assert(evaluateProgram<1>(memory_equals).resume_point == 0);
+
+        constexpr auto memory_larger = parseConstexprMemory<47>(
+            "3,21,1008,21,8,20,1005,20,22,107,8,21,20,1006,20,31,"
+            "1106,0,36,98,0,0,1002,21,125,20,4,20,1105,1,46,104,"
+            "999,1105,1,46,1101,1000,1,20,4,20,1105,1,46,98,99");
+        static_assert(evaluateProgram<1>(memory_larger, std::array<Word, 1>{ 7 }).output[0] == 999);
+        static_assert(evaluateProgram<1>(memory_larger, std::array<Word, 1>{ 8 }).output[0] == 1000);
+        static_assert(evaluateProgram<1>(memory_larger, std::array<Word, 1>{ 9 }).output[0] == 1001);
+
+        constexpr char quine[] = "109,1,204,-1,1001,100,1,100,1008,100,16,101,1006,101,0,99";
+        constexpr auto memory_quine = parseConstexprMemory<102>(quine);
+        constexpr auto p_quine = evaluateProgram<16>(memory_quine);
+        static_assert(p_quine.pc == ResultCode::Halted);
+        static_assert(p_quine.output.size() == 16);
+        static_assert(std::equal(p_quine.output.begin(), p_quine.output.end(), memory_quine.begin()));
+
+        auto p_runtime = parseInput(quine);
+        executeProgram(p_runtime);
+        CHECK(std::equal(p_quine.output.begin(), p_quine.output.end(), p_runtime.output.begin(), p_runtime.output.end()));
+    }
 }
 